@@ -31,9 +31,15 @@
 
 // Project uses C++17 standard
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <string_view>
 
 // ---- Compiler / platform helpers ----
 #if defined(_MSC_VER)
@@ -93,18 +99,19 @@ struct Color {
     Color() = default;
     Color(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = 255)
         : r(red), g(green), b(blue), a(alpha) {}
-    Color(const std::string& hex) {
-        if (hex.length() == 6) {
-            r = static_cast<uint8_t>(std::stoi(hex.substr(0, 2), nullptr, 16));
-            g = static_cast<uint8_t>(std::stoi(hex.substr(2, 2), nullptr, 16));
-            b = static_cast<uint8_t>(std::stoi(hex.substr(4, 2), nullptr, 16));
-        }
-        else if (hex.length() == 8) {
-            r = static_cast<uint8_t>(std::stoi(hex.substr(0, 2), nullptr, 16));
-            g = static_cast<uint8_t>(std::stoi(hex.substr(2, 2), nullptr, 16));
-            b = static_cast<uint8_t>(std::stoi(hex.substr(4, 2), nullptr, 16));
-            a = static_cast<uint8_t>(std::stoi(hex.substr(6, 2), nullptr, 16));
+    // Parses RRGGBB or RRGGBBAA; any other value (e.g. "auto") leaves the
+    // default color. Does not allocate nor throw.
+    Color(std::string_view hex) {
+        if (hex.length() != 6 && hex.length() != 8)
+            return;
+        uint8_t c[4] = { 0, 0, 0, 255 };
+        for (size_t i = 0; i < hex.length(); i += 2) {
+            int hi = hexDigit(hex[i]), lo = hexDigit(hex[i + 1]);
+            if (hi < 0 || lo < 0)
+                return;
+            c[i / 2] = static_cast<uint8_t>(hi << 4 | lo);
         }
+        r = c[0]; g = c[1]; b = c[2]; a = c[3];
     }
 
     bool empty() const {
@@ -114,8 +121,66 @@ struct Color {
     bool operator==(const Color& other) const {
         return r == other.r && g == other.g && b == other.b && a == other.a;
     }
+
+private:
+    // @return value of a hex digit, -1 if c is not one
+    static int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+};
+
+// Arena allocator
+// Allocates from a memory resource owned by an ArenaDocument, or from the
+// global heap when no resource is set. The allocator moves along with the
+// container, and copies of a container always go to the global heap, so
+// they do not depend on the arena.
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    std::pmr::memory_resource* resource = nullptr;  // null = global heap
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(std::pmr::memory_resource* res) noexcept : resource(res) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : resource(other.resource) {}
+
+    T* allocate(size_t n) {
+        if (!resource)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        if (!resource)
+            ::operator delete(p);
+        else
+            resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+    ArenaAllocator select_on_container_copy_construction() const {
+        return ArenaAllocator();
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return resource == other.resource; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return resource != other.resource; }
 };
 
+// String and vector of the document structures, by allocator template
+template <template <class> class Alloc>
+using BasicString = std::basic_string<char, std::char_traits<char>, Alloc<char>>;
+template <class T, template <class> class Alloc>
+using BasicVector = std::vector<T, Alloc<T>>;
+
+template <class T>
+using ArenaVector = BasicVector<T, ArenaAllocator>;
+using ArenaString = BasicString<ArenaAllocator>;
+
 // Tab stop structure
 struct Tab {
     float position = 0.0f;              // in points
@@ -161,9 +226,60 @@ struct Style {
     std::vector<Tab> tabs;              // tab stops
 };
 
+// Run format structure
+// Represents the formatting of a text run
+// Each distinct format is stored once in Document::runFormats
+struct RunFormat {
+    std::string lang;                   // style properties
+    std::string style;                  // style ID
+    bool        bold        = false;    // the 'bold' style
+    bool        italic      = false;    // the 'italic' style
+    bool        underline   = false;    // the text has line under the text
+    bool        strike      = false;    // the text has line through the text
+    bool        subscript   = false;    // the text is subscript, e.g. for footnotes
+    bool        superscript = false;    // the text is superscript
+    Color       color;                  // the color of the text
+    Color       backColor;              // the background color of the text     
+    std::string fontFamily;             // font family name (e.g. Arial)
+    float       fontSize    = 0.0f;     // font size in points
+
+    bool operator==(const RunFormat& other) const {
+        return bold == other.bold && italic == other.italic &&
+               underline == other.underline && strike == other.strike &&
+               subscript == other.subscript && superscript == other.superscript &&
+               fontSize == other.fontSize &&
+               color == other.color && backColor == other.backColor &&
+               lang == other.lang && style == other.style &&
+               fontFamily == other.fontFamily;
+    }
+};
+
+// Document structures
+// Runs, paragraphs, notes, tables and documents are templates over the
+// allocator of their text and containers. Run, Paragraph, Note, Table and
+// Document use std::string and std::vector; ArenaRun, ArenaParagraph,
+// ArenaNote, ArenaTable and ArenaDocument allocate from the arena of an
+// ArenaDocument, see readArenaDocument.
+
+// Run structure
+// Represents a text run in a paragraph
+template <template <class> class Alloc>
+struct BasicRun {
+    BasicString<Alloc> text;            // run text
+    uint32_t    format      = 0;        // index into Document::runFormats
+                                        // (0 = default format)
+
+    // for Notes:
+    uint32_t    noteId      = 0;        // the footnote / endnote ID
+};
+
+using Run = BasicRun<std::allocator>;
+using ArenaRun = BasicRun<ArenaAllocator>;
+
 // Paragraph structure
 // Represents a paragraph in the document
-struct Paragraph {
+template <template <class> class Alloc>
+struct BasicParagraph {
     std::string style;                  // style ID
 
     // numbering
@@ -184,63 +300,386 @@ struct Paragraph {
     float       indentRight = 0.0f;     // right indent in points
     float       indentFirstLine = 0.0f; // first line indent in points
     // tabs
-    std::vector<Tab> tabs;              // tab stops
+    BasicVector<Tab, Alloc> tabs;       // tab stops
 
     // runs
-    std::vector<Run> runs;              // vector of runs in the paragraph
+    BasicVector<BasicRun<Alloc>, Alloc> runs; // vector of runs in the paragraph
 };
 
-// Run structure
-// Represents a text run in a paragraph
-struct Run {
-    std::string text;                   // run text
-    std::string lang;                   // style properties
-    std::string style;                  // style ID
-    bool        bold        = false;    // the 'bold' style
-    bool        italic      = false;    // the 'italic' style
-    bool        underline   = false;    // the text has line under the text
-    bool        strike      = false;    // the text has line through the text
-    bool        subscript   = false;    // the text is subscript, e.g. for footnotes
-    bool        superscript = false;    // the text is superscript
-    Color       color;                  // the color of the text
-    Color       backColor;              // the background color of the text     
-    std::string fontFamily;             // font family name (e.g. Arial)
-    float       fontSize    = 0.0f;     // font size in points
-
-    // for Notes:
-    uint32_t    noteId      = 0;        // the footnote / endnote ID
-};
+using Paragraph = BasicParagraph<std::allocator>;
+using ArenaParagraph = BasicParagraph<ArenaAllocator>;
 
 // Note structure
 // Represents a footnote or endnote
-struct Note{
+template <template <class> class Alloc>
+struct BasicNote{
     int         id;                     // footnote ID
-    std::vector<Paragraph> paragraphs;  // footnote text
+    BasicVector<BasicParagraph<Alloc>, Alloc> paragraphs; // footnote text
+};
+
+using Note = BasicNote<std::allocator>;
+using ArenaNote = BasicNote<ArenaAllocator>;
+
+// Table cell structure
+// The paragraphs of a cell, nested tables included, are the range
+// [firstParagraph, firstParagraph + paragraphCount) of Document::paragraphs
+struct TableCell {
+    uint32_t    firstParagraph = 0;     // index of the first paragraph of the cell
+    uint32_t    paragraphCount = 0;     // number of paragraphs in the cell
+    uint32_t    gridSpan = 1;           // number of grid columns spanned
+    bool        mergedAbove = false;    // continues the vertically merged cell above
 };
 
+// Table row structure
+// The cells of a row are the range [firstCell, firstCell + cellCount) of
+// Table::cells
+struct TableRow {
+    uint32_t    firstCell = 0;          // index of the first cell of the row
+    uint32_t    cellCount = 0;          // number of cells in the row
+};
+
+// Table structure
+// Represents a w:tbl. Rows and cells are stored flat, row after row, and a
+// cell refers to its paragraphs by index, so a table costs two arrays
+// however many cells it has. The paragraphs of the table are part of
+// Document::paragraphs, in document order; a table nested in a cell is
+// a Table of its own, listed after the table containing it.
+template <template <class> class Alloc>
+struct BasicTable {
+    uint32_t    level = 0;              // 0 for body tables, n for tables nested n cells deep
+    uint32_t    firstParagraph = 0;     // index of the first paragraph of the table
+    uint32_t    paragraphCount = 0;     // number of paragraphs in the table
+    BasicVector<TableRow, Alloc>  rows;   // rows of the table
+    BasicVector<TableCell, Alloc> cells;  // cells of all rows, row after row
+};
+
+using Table = BasicTable<std::allocator>;
+using ArenaTable = BasicTable<ArenaAllocator>;
+
 // Document structure
 // Represents the entire document
-struct Document {
-    std::vector<Paragraph> paragraphs;  // vector of paragraphs in the document
+template <template <class> class Alloc>
+struct BasicDocument {
+    BasicVector<BasicParagraph<Alloc>, Alloc> paragraphs; // vector of paragraphs in the document, tables included
+    BasicVector<BasicTable<Alloc>, Alloc> tables;         // tables of the document, see Table
+    std::vector<RunFormat> runFormats;  // distinct run formats, indexed by Run::format
     std::unordered_map<std::string, Style> styles; // map of style ID to Style
-    std::unordered_map<int, Note> footnotes; // map of footnote ID to Note
-    std::unordered_map<int, Note> endnotes;  // map of endnote ID to Note
+    std::unordered_map<int, BasicNote<Alloc>> footnotes; // map of footnote ID to Note
+    std::unordered_map<int, BasicNote<Alloc>> endnotes;  // map of endnote ID to Note
+
+    // @return the format of a run of this document
+    const RunFormat& format(const BasicRun<Alloc>& run) const {
+        return runFormats[run.format];
+    }
+};
+
+using Document = BasicDocument<std::allocator>;
+
+// Document memory arena
+// Holds the memory of an ArenaDocument (opaque)
+struct DocumentArena;
+
+// Arena-backed document structure
+// A document whose paragraphs, runs, tab stops and text are allocated from
+// a few large blocks it owns, one per part, and released at once when it is
+// destroyed. Anything moved out of it (an ArenaParagraph, an ArenaNote, a
+// run text) still lives in its arena and must not outlive it; copy it
+// instead, copies always go to the heap.
+struct ArenaDocument : BasicDocument<ArenaAllocator> {
+    std::shared_ptr<DocumentArena> arena; // memory of the content, null for a copy
+
+    ArenaDocument() = default;
+    ArenaDocument(ArenaDocument&& other) noexcept = default;
+    // Copies are heap-backed
+    MINIDOCKLIB_API ArenaDocument(const ArenaDocument& other);
+    // The content is released before the arena it lives in
+    MINIDOCKLIB_API ~ArenaDocument();
+    MINIDOCKLIB_API ArenaDocument& operator=(ArenaDocument&& other) noexcept;
+    MINIDOCKLIB_API ArenaDocument& operator=(const ArenaDocument& other);
+};
+
+// Lazy document state
+// Holds the open archive and the parsed parts of a LazyDocument (opaque)
+struct LazyDocumentState;
+
+// Lazy document structure
+// A document whose body is parsed when it is opened, while styles, footnotes
+// and endnotes are inflated and parsed on their first access. The archive
+// (or its memory mapping) stays open as long as a copy of the document is
+// alive. The accessors are thread-safe and parse each part exactly once;
+// the references they return stay valid as long as the document.
+struct LazyDocument {
+    std::shared_ptr<LazyDocumentState> state; // null if the document could not be opened
+
+    // @return true if the document was opened
+    MINIDOCKLIB_API bool isOpen() const;
+    // @return paragraphs of the body, tables included
+    MINIDOCKLIB_API const std::vector<Paragraph>& paragraphs() const;
+    // @return tables of the body
+    MINIDOCKLIB_API const std::vector<Table>& tables() const;
+    // @return map of style ID to Style, parsed on first call
+    MINIDOCKLIB_API const std::unordered_map<std::string, Style>& styles() const;
+    // @return map of footnote ID to Note, parsed on first call
+    MINIDOCKLIB_API const std::unordered_map<int, Note>& footnotes() const;
+    // @return map of endnote ID to Note, parsed on first call
+    MINIDOCKLIB_API const std::unordered_map<int, Note>& endnotes() const;
+    // @return the format of a run of this document (body or notes), the
+    //         default format if the document is not open
+    MINIDOCKLIB_API const RunFormat& format(const Run& run) const;
+};
+
+// Run view structure
+// Zero-copy variant of Run, see DocumentView
+struct RunView {
+    std::string_view text;              // run text, inside DocumentView::buffer
+    uint32_t    format      = 0;        // index into DocumentView::runFormats
+                                        // (0 = default format)
+    uint32_t    noteId      = 0;        // the footnote / endnote ID
+};
+
+// Paragraph view structure
+// Zero-copy variant of Paragraph, see DocumentView
+struct ParagraphView {
+    std::string style;                  // style ID
+    std::vector<RunView> runs;          // runs of the paragraph
+};
+
+// Document view structure
+// Zero-copy variant of Document for text extraction.
+// document.xml is decompressed once and kept by the view; entities are
+// decoded in place in that buffer and run texts point into it, so no text
+// is copied. Only the body is read, and adjacent runs with the same format
+// are not merged since their texts are not contiguous in the buffer.
+struct DocumentView {
+    std::shared_ptr<const std::string> buffer; // decompressed document.xml
+    std::vector<ParagraphView> paragraphs;     // paragraphs of the body, tables included
+    std::vector<RunFormat> runFormats;         // distinct run formats, indexed by RunView::format
+
+    // @return the format of a run of this view
+    const RunFormat& format(const RunView& run) const {
+        return runFormats[run.format];
+    }
+};
+
+// Shared style cache
+// Parsed styles.xml parts shared across documents (opaque), see createStyleCache
+struct StyleCache;
+
+// Read options structure
+// Controls how a document is read
+struct ReadOptions {
+    bool intraDocumentParallelism = false;  // decompress and parse the parts of
+                                            // one document on separate threads
+    bool memoryMap = false;                 // readDocument: map the file into memory
+                                            // instead of reading it through stdio
+    std::shared_ptr<StyleCache> styleCache; // reuse the styles of documents built from
+                                            // the same template, null = no sharing
+    // Parts and work to skip, for consumers that need only some of the content
+    bool readStyles = true;                 // load styles.xml (Document::styles and
+                                            // formatting inherited from styles)
+    bool readFootnotes = true;              // load footnotes.xml (Document::footnotes)
+    bool readEndnotes = true;               // load endnotes.xml (Document::endnotes)
+    bool resolveFormatting = true;          // resolve paragraph and run formatting; when
+                                            // false every run has the default format, so
+                                            // each paragraph holds its text in few runs
+};
+
+// Memory buffer structure
+// Describes one in-memory document for batch reading
+struct MemoryBuffer {
+    const char* data = nullptr;         // pointer to the in-memory data
+    size_t      size = 0;               // size of the in-memory data
 };
 
+// Batch result callback
+// Receives each document of a batch as soon as it has been parsed.
+// Called from the worker threads, so calls may run concurrently.
+// @param index: index of the document in the input list
+// @param doc: the parsed document
+using DocumentCallback = std::function<void(size_t index, Document&& doc)>;
+
+// Paragraph callback
+// Receives the body paragraphs of a document one by one, in document order,
+// those of tables and content controls included.
+// The paragraph may be moved from; it is not kept by the reader.
+// @param para: the parsed paragraph
+// @param runFormats: run formats read so far, indexed by Run::format;
+//                    the table only grows, so indices stay valid
+// @return true to continue, false to stop reading
+using ParagraphCallback = std::function<bool(Paragraph&& para,
+                                             const std::vector<RunFormat>& runFormats)>;
+
 
 
 // API function declarations
 
 // Reads a MiniDock document from a file path
 // @param path: path to the MiniDock (.docx) file
+// @param options: read options
 // @return Document structure representing the document
 MINIDOCKLIB_API Document readDocument(
-      const std::string& path);
+      const std::string& path,
+      const ReadOptions& options = ReadOptions());
 
 // Reads a MiniDock document from in-memory data
 // @param data: pointer to the in-memory data
 // @param size: size of the in-memory data
+// @param options: read options
 // @return Document structure representing the document
 MINIDOCKLIB_API Document readDocumentFromMemory(
-    const char* data,
-    size_t      size);
+    const char*        data,
+    size_t             size,
+    const ReadOptions& options = ReadOptions());
+
+// Reads a MiniDock document into an arena from a file path
+// Parsing does a handful of large allocations, and destroying the document
+// releases them at once; see ArenaDocument.
+// @param path: path to the MiniDock (.docx) file
+// @param options: read options
+// @return ArenaDocument structure representing the document
+MINIDOCKLIB_API ArenaDocument readArenaDocument(
+    const std::string& path,
+    const ReadOptions& options = ReadOptions());
+
+// Reads a MiniDock document into an arena from in-memory data
+// @param data: pointer to the in-memory data
+// @param size: size of the in-memory data
+// @param options: read options
+// @return ArenaDocument structure representing the document
+MINIDOCKLIB_API ArenaDocument readArenaDocumentFromMemory(
+    const char*        data,
+    size_t             size,
+    const ReadOptions& options = ReadOptions());
+
+// Reads a batch of MiniDock documents from file paths in parallel
+// Documents are distributed over a work-stealing thread pool, so a few
+// large documents do not leave the other threads idle.
+// Returns after all documents were delivered; the first exception thrown
+// while reading a document is rethrown to the caller.
+// @param paths: paths to the MiniDock (.docx) files
+// @param threads: number of worker threads (0 = hardware concurrency)
+// @param onDocument: callback receiving each parsed document
+// @param options: read options applied to every document
+MINIDOCKLIB_API void readDocuments(
+    const std::vector<std::string>& paths,
+    unsigned                        threads,
+    const DocumentCallback&         onDocument,
+    const ReadOptions&              options = ReadOptions());
+
+// Reads a batch of MiniDock documents from in-memory data in parallel
+// Same as readDocuments, for documents already loaded into memory
+// @param buffers: the in-memory documents
+// @param threads: number of worker threads (0 = hardware concurrency)
+// @param onDocument: callback receiving each parsed document
+// @param options: read options applied to every document
+MINIDOCKLIB_API void readDocumentsFromMemory(
+    const std::vector<MemoryBuffer>& buffers,
+    unsigned                         threads,
+    const DocumentCallback&          onDocument,
+    const ReadOptions&               options = ReadOptions());
+
+// Streams the paragraphs of a MiniDock document from a file path
+// Each body paragraph is handed to the callback as soon as it is parsed
+// and is not retained. The body is parsed one paragraph at a time, however
+// deeply it is nested in tables and content controls, so memory is bounded
+// by the largest paragraph (with its text boxes), not the document length.
+// Only styles and the main document are read; notes are skipped.
+// @param path: path to the MiniDock (.docx) file
+// @param onParagraph: callback receiving each paragraph
+// @param options: read options (notes are never read)
+// @return false if the document could not be opened
+MINIDOCKLIB_API bool forEachParagraph(
+    const std::string&       path,
+    const ParagraphCallback& onParagraph,
+    const ReadOptions&       options = ReadOptions());
+
+// Streams the paragraphs of a MiniDock document from in-memory data
+// Same as forEachParagraph, for a document already loaded into memory
+// @param data: pointer to the in-memory data
+// @param size: size of the in-memory data
+// @param onParagraph: callback receiving each paragraph
+// @param options: read options (notes are never read)
+// @return false if the document could not be opened
+MINIDOCKLIB_API bool forEachParagraphFromMemory(
+    const char*              data,
+    size_t                   size,
+    const ParagraphCallback& onParagraph,
+    const ReadOptions&       options = ReadOptions());
+
+// Reads the body of a MiniDock document from a file path without copying text
+// See DocumentView; the run texts stay valid as long as the view (or a
+// copy of its buffer pointer) is alive.
+// @param path: path to the MiniDock (.docx) file
+// @param options: read options (notes are never read)
+// @return DocumentView of the document body
+MINIDOCKLIB_API DocumentView readDocumentView(
+    const std::string& path,
+    const ReadOptions& options = ReadOptions());
+
+// Reads the body of a MiniDock document from in-memory data without copying text
+// @param data: pointer to the in-memory data
+// @param size: size of the in-memory data
+// @param options: read options (notes are never read)
+// @return DocumentView of the document body
+MINIDOCKLIB_API DocumentView readDocumentViewFromMemory(
+    const char*        data,
+    size_t             size,
+    const ReadOptions& options = ReadOptions());
+
+// Creates a style cache to share through ReadOptions::styleCache
+// Documents whose styles.xml has the same CRC32 and size as a cached one
+// skip inflating and parsing it. The cache is thread-safe, so one cache
+// may serve a whole batch.
+// @param capacity: maximum number of distinct styles parts kept
+// @return the new cache
+MINIDOCKLIB_API std::shared_ptr<StyleCache> createStyleCache(size_t capacity = 64);
+
+// Opens a MiniDock document for lazy reading from a file path
+// Only the body (and the styles it needs) is read now; see LazyDocument.
+// readFootnotes and readEndnotes are ignored, notes are read on access.
+// @param path: path to the MiniDock (.docx) file
+// @param options: read options
+// @return LazyDocument, not open if the file could not be opened
+MINIDOCKLIB_API LazyDocument openDocument(
+    const std::string& path,
+    const ReadOptions& options = ReadOptions());
+
+// Opens a MiniDock document for lazy reading from in-memory data
+// @param data: pointer to the in-memory data, must outlive the document
+// @param size: size of the in-memory data
+// @param options: read options
+// @return LazyDocument, not open if the data is not a valid archive
+MINIDOCKLIB_API LazyDocument openDocumentFromMemory(
+    const char*        data,
+    size_t             size,
+    const ReadOptions& options = ReadOptions());
+
+// Extracts the plain text of a MiniDock document from a file path
+// A fast path for indexing: the parts are scanned for their w:t text without
+// building a DOM, resolving styles or creating runs. Each paragraph ends
+// with '\n'; tabs become '\t' and line breaks a space. The body comes
+// first, then the footnotes and endnotes if options.readFootnotes /
+// options.readEndnotes are set. Paragraphs nested in tables and text boxes
+// are included, in the order of readDocument: the paragraphs of a text box
+// follow the paragraph anchoring it, and the body ends where readDocument
+// stops reading it.
+// The text differs from that of the readDocument paragraphs where the fast
+// path cannot match it: tabs and line breaks are kept as characters, every
+// w:t of a run is kept (not only the first), and the XML is not validated,
+// so a malformed paragraph or notes part still yields the text it holds.
+// @param path: path to the MiniDock (.docx) file
+// @param options: read options (memoryMap, readFootnotes and readEndnotes apply)
+// @return the text, empty if the document could not be opened
+MINIDOCKLIB_API std::string extractText(
+    const std::string& path,
+    const ReadOptions& options = ReadOptions());
+
+// Extracts the plain text of a MiniDock document from in-memory data
+// @param data: pointer to the in-memory data
+// @param size: size of the in-memory data
+// @param options: read options (readFootnotes and readEndnotes apply)
+// @return the text, empty if the data is not a valid archive
+MINIDOCKLIB_API std::string extractTextFromMemory(
+    const char*        data,
+    size_t             size,
+    const ReadOptions& options = ReadOptions());
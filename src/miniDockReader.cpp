@@ -2,6 +2,27 @@
 // Implementation file for miniDockReader library
 
 #include "../miniDockReader.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+#if defined(MINIDOCKLIB_PLATFORM_WINDOWS)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
 #include "../thirdparty/miniz-cpp-master/zip_file.hpp"
 #include "../thirdparty/tinyxml2-master/tinyxml2.h"
 
@@ -10,875 +31,3290 @@ using namespace tinyxml2;
 // ---------------- Internal Data Structures ----------------
 
 using StyleMap = std::unordered_map<std::string, Style>;
-static std::unordered_map<std::string, Style> g_mergedStyleCache; // cache for merged styles
-
-// -------------- Style merge (cached) --------------
-// Merges styles with inheritance, using a cache for performance
-// @param styles: map of styleId -> Style
-// @param styleId: style ID to merge
-// @return merged Style
-static Style mergeStyleCached(const StyleMap &styles, const std::string &styleId)
-{
-    Style result;
-    if (styleId.empty())
-        return result;
-
-    auto itc = g_mergedStyleCache.find(styleId);
-    if (itc != g_mergedStyleCache.end())
-        return itc->second;
-
-    auto it = styles.find(styleId);
-    if (it == styles.end())
-    {
-        g_mergedStyleCache[styleId] = result;
-        return result;
-    }
-
-    const Style &cur = it->second;
-    if (!cur.basedOn.empty())
-        result = mergeStyleCached(styles, cur.basedOn);
-
-    // Style type
-    // @todo: verify correct behavior here
-    if (cur.styleType != ElementType::Paragraph && cur.styleType != ElementType::Run)
-        result.styleType = cur.styleType;
-
-    // Character properties
-    if (cur.bold)
-        result.bold = true;
-    if (cur.italic)
-        result.italic = true;
-    if (cur.underline)
-        result.underline = true;
-    if (cur.strikeThrough)
-        result.strikeThrough = true;
-    if (cur.Subscript)
-        result.Subscript = true;
-    if (cur.Superscript)
-        result.Superscript = true;
-
-    // Colors and font
-    if (!cur.color.empty())
-        result.color = cur.color;
-    if (!cur.backColor.empty())
-        result.backColor = cur.backColor;
-    if (!cur.fontFamily.empty())
-        result.fontFamily = cur.fontFamily;
-    if (cur.fontSize > 0)
-        result.fontSize = cur.fontSize;
-
-    // Paragraph properties
-    if (cur.lineSpacing > 0)
-        result.lineSpacing = cur.lineSpacing;
-    if (cur.spaceBefore > 0)
-        result.spaceBefore = cur.spaceBefore;
-    if (cur.spaceAfter > 0)
-        result.spaceAfter = cur.spaceAfter;
-    if (cur.spaceBetweenSameStyle)
-        result.spaceBetweenSameStyle = true;
-    if (cur.justification != Justification::Left)
-        result.justification = cur.justification;
-    if (cur.rightDirection)
-        result.rightDirection = true;
-    if (cur.indentLeft > 0)
-        result.indentLeft = cur.indentLeft;
-    if (cur.indentRight > 0)
-        result.indentRight = cur.indentRight;
-    if (cur.indentFirstLine > 0)
-        result.indentFirstLine = cur.indentFirstLine;
-
-    // Tabs
-    if (!cur.tabs.empty())
-    {
-        result.tabs.insert(result.tabs.end(), cur.tabs.begin(), cur.tabs.end());
-    }
-
-    // numbering
-    if (cur.numbered)
-        result.numbered = true;
-    if (!cur.numberFormat.empty())
-        result.numberFormat = cur.numberFormat;
-    if (!cur.numberStyle.empty())
-        result.numberStyle = cur.numberStyle;
-    if (cur.level > 0)
-        result.level = cur.level;
-
-    g_mergedStyleCache[styleId] = result;
-    return result;
-}
-
-
-// -------- ZIP: read multiple files --------
-// Reads multiple files from a ZIP archive
-// @param path: path to ZIP file
-// @param files: list of filenames to read
-// @return map of filename -> file data
-static std::unordered_map<std::string, std::string>
-readMultipleFilesFromZIP(const std::string &path,
-                         const std::vector<std::string> &files)
-{
-    std::unordered_map<std::string, std::string> out;
-    mz_zip_archive zip;
-    std::memset(&zip, 0, sizeof(zip));
-
-    if (!mz_zip_reader_init_file(&zip, path.c_str(), 0))
-        return out;
-
-    // Iterate through files in the ZIP
-    int n = mz_zip_reader_get_num_files(&zip);
-    for (int i = 0; i < n; ++i)
+
+// Run format hash
+// Hashes every field compared by RunFormat::operator==
+struct RunFormatHash {
+    size_t operator()(const RunFormat &f) const
     {
-        mz_zip_archive_file_stat st;
-        if (!mz_zip_reader_file_stat(&zip, i, &st))
-            continue;
+        size_t h = std::hash<std::string>()(f.fontFamily);
+        auto mix = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+        mix(std::hash<std::string>()(f.lang));
+        mix(std::hash<std::string>()(f.style));
+        mix(std::hash<float>()(f.fontSize));
+        mix((size_t(f.color.r) << 24) | (size_t(f.color.g) << 16) | (size_t(f.color.b) << 8) | f.color.a);
+        mix((size_t(f.backColor.r) << 24) | (size_t(f.backColor.g) << 16) | (size_t(f.backColor.b) << 8) | f.backColor.a);
+        mix((size_t(f.bold) << 0) | (size_t(f.italic) << 1) | (size_t(f.underline) << 2) |
+            (size_t(f.strike) << 3) | (size_t(f.subscript) << 4) | (size_t(f.superscript) << 5));
+        return h;
+    }
+};
+
+// Run format table
+// Interns run formats, so equal formats share one ID
+// ID 0 is always the default format
+// A table is only locked when parts of a document intern into it from
+// several threads (shared); a single-threaded parse never takes the mutex.
+struct RunFormatTable {
+    std::vector<RunFormat> formats{RunFormat()};                    // formats by ID
+    std::unordered_map<RunFormat, uint32_t, RunFormatHash> ids{{RunFormat(), 0}};  // format -> ID
+    std::mutex mutex;                                               // guards both when shared
+    bool shared = false;                                            // interned from several threads
+
+    // Interns a format
+    // @param f: format to intern
+    // @return ID of the format
+    uint32_t intern(const RunFormat &f)
+    {
+        if (!shared)
+            return insert(f);
+        std::lock_guard<std::mutex> lock(mutex);
+        return insert(f);
+    }
+
+private:
+    // @return ID of the format, added if new
+    uint32_t insert(const RunFormat &f)
+    {
+        auto it = ids.find(f);
+        if (it != ids.end())
+            return it->second;
+        uint32_t id = static_cast<uint32_t>(formats.size());
+        formats.push_back(f);
+        ids.emplace(f, id);
+        return id;
+    }
+};
+
+// Property set
+// Run and paragraph properties of a w:rPr / w:pPr, of a style or of direct
+// formatting. Each property has a bit in 'has', set when the property was
+// given, so sets merge by overlaying only the properties present.
+struct PropertySet {
+    enum : uint32_t {
+        // boolean properties, their values are the same bits of 'flags'
+        HasBold             = 1u << 0,
+        HasItalic           = 1u << 1,
+        HasUnderline        = 1u << 2,
+        HasStrike           = 1u << 3,
+        HasSubscript        = 1u << 4,
+        HasSuperscript      = 1u << 5,
+        HasNumbered         = 1u << 6,
+        HasExactSpacing     = 1u << 7,
+        HasRightDirection   = 1u << 8,
+        BooleanMask         = (1u << 9) - 1,
+        // valued properties
+        HasColor            = 1u << 9,
+        HasBackColor        = 1u << 10,
+        HasFontFamily       = 1u << 11,
+        HasFontSize         = 1u << 12,
+        HasLang             = 1u << 13,
+        HasLevel            = 1u << 14,
+        HasNumberFormat     = 1u << 15,
+        HasNumberStyle      = 1u << 16,
+        HasLineSpacing      = 1u << 17,
+        HasSpaceBefore      = 1u << 18,
+        HasSpaceAfter       = 1u << 19,
+        HasJustification    = 1u << 20,
+        HasIndentLeft       = 1u << 21,
+        HasIndentRight      = 1u << 22,
+        HasIndentFirstLine  = 1u << 23,
+        HasTabs             = 1u << 24,
+    };
+
+    uint32_t    has = 0;                // properties present
+    uint32_t    flags = 0;              // values of the boolean properties
+    // run properties
+    Color       color;
+    Color       backColor;
+    std::string fontFamily;
+    float       fontSize = 0.0f;
+    std::string lang;
+    // paragraph properties
+    int         level = 0;
+    std::string numberFormat;
+    std::string numberStyle;
+    float       lineSpacing = 1.0f;
+    float       spaceBefore = 0.0f;
+    float       spaceAfter = 0.0f;
+    Justification justification = Justification::Left;
+    float       indentLeft = 0.0f;
+    float       indentRight = 0.0f;
+    float       indentFirstLine = 0.0f;
+    std::vector<Tab> tabs;
+
+    // @param bit: Has* bit of a boolean property
+    // @return true if the property is present and on
+    bool flag(uint32_t bit) const { return (flags & bit) != 0; }
+
+    // Sets a boolean property
+    // @param bit: Has* bit of the property
+    // @param on: value of the property
+    void setFlag(uint32_t bit, bool on)
+    {
+        has |= bit;
+        flags = on ? (flags | bit) : (flags & ~bit);
+    }
 
-        for (const auto &name : files)
+    // Overlays the properties present in another set
+    // Tab stops accumulate, as along a basedOn chain.
+    // @param src: set whose properties take precedence
+    void overlay(const PropertySet &src)
+    {
+        uint32_t booleans = src.has & BooleanMask;
+        flags = (flags & ~booleans) | (src.flags & booleans);
+        for (uint32_t values = src.has & ~BooleanMask; values; values &= values - 1)
         {
-            if (std::strcmp(st.m_filename, name.c_str()) == 0)
+            switch (values & (0u - values))
             {
-                std::string data;
-                data.resize(static_cast<size_t>(st.m_uncomp_size));
-                if (!mz_zip_reader_extract_file_to_mem(
-                        &zip, st.m_filename, data.data(), st.m_uncomp_size, 0))
-                    data.clear();
-                out[name] = std::move(data);
-                break;
+            case HasColor:           color = src.color; break;
+            case HasBackColor:       backColor = src.backColor; break;
+            case HasFontFamily:      fontFamily = src.fontFamily; break;
+            case HasFontSize:        fontSize = src.fontSize; break;
+            case HasLang:            lang = src.lang; break;
+            case HasLevel:           level = src.level; break;
+            case HasNumberFormat:    numberFormat = src.numberFormat; break;
+            case HasNumberStyle:     numberStyle = src.numberStyle; break;
+            case HasLineSpacing:     lineSpacing = src.lineSpacing; break;
+            case HasSpaceBefore:     spaceBefore = src.spaceBefore; break;
+            case HasSpaceAfter:      spaceAfter = src.spaceAfter; break;
+            case HasJustification:   justification = src.justification; break;
+            case HasIndentLeft:      indentLeft = src.indentLeft; break;
+            case HasIndentRight:     indentRight = src.indentRight; break;
+            case HasIndentFirstLine: indentFirstLine = src.indentFirstLine; break;
+            case HasTabs:            tabs.insert(tabs.end(), src.tabs.begin(), src.tabs.end()); break;
             }
         }
+        has |= src.has;
     }
+};
 
-    mz_zip_reader_end(&zip);
-    return out;
+// Applies the run properties present in a set to a run format
+// @param fmt: run format, updated in place
+// @param set: properties to apply
+static void applyRunProperties(RunFormat &fmt, const PropertySet &set)
+{
+    if (set.has & PropertySet::HasBold)        fmt.bold = set.flag(PropertySet::HasBold);
+    if (set.has & PropertySet::HasItalic)      fmt.italic = set.flag(PropertySet::HasItalic);
+    if (set.has & PropertySet::HasUnderline)   fmt.underline = set.flag(PropertySet::HasUnderline);
+    if (set.has & PropertySet::HasStrike)      fmt.strike = set.flag(PropertySet::HasStrike);
+    if (set.has & PropertySet::HasSubscript)   fmt.subscript = set.flag(PropertySet::HasSubscript);
+    if (set.has & PropertySet::HasSuperscript) fmt.superscript = set.flag(PropertySet::HasSuperscript);
+    if (set.has & PropertySet::HasColor)       fmt.color = set.color;
+    if (set.has & PropertySet::HasBackColor)   fmt.backColor = set.backColor;
+    if (set.has & PropertySet::HasFontFamily)  fmt.fontFamily = set.fontFamily;
+    if (set.has & PropertySet::HasFontSize)    fmt.fontSize = set.fontSize;
+    if (set.has & PropertySet::HasLang)        fmt.lang = set.lang;
 }
 
+// Applies the paragraph properties present in a set to a paragraph
+// Tab stops of the set replace those of the paragraph.
+// @param para: paragraph, updated in place
+// @param set: properties to apply
+template <template <class> class Alloc>
+static void applyParagraphProperties(BasicParagraph<Alloc> &para, const PropertySet &set)
+{
+    if (set.has & PropertySet::HasNumbered)       para.numbered = set.flag(PropertySet::HasNumbered);
+    if (set.has & PropertySet::HasExactSpacing)   para.spaceBetweenSameStyle = set.flag(PropertySet::HasExactSpacing);
+    if (set.has & PropertySet::HasRightDirection) para.rightDirection = set.flag(PropertySet::HasRightDirection);
+    if (set.has & PropertySet::HasLevel)          para.level = set.level;
+    if (set.has & PropertySet::HasNumberFormat)   para.numberFormat = set.numberFormat;
+    if (set.has & PropertySet::HasNumberStyle)    para.numberStyle = set.numberStyle;
+    if (set.has & PropertySet::HasLineSpacing)    para.lineSpacing = set.lineSpacing;
+    if (set.has & PropertySet::HasSpaceBefore)    para.spaceBefore = set.spaceBefore;
+    if (set.has & PropertySet::HasSpaceAfter)     para.spaceAfter = set.spaceAfter;
+    if (set.has & PropertySet::HasJustification)  para.justification = set.justification;
+    if (set.has & PropertySet::HasIndentLeft)     para.indentLeft = set.indentLeft;
+    if (set.has & PropertySet::HasIndentRight)    para.indentRight = set.indentRight;
+    if (set.has & PropertySet::HasIndentFirstLine) para.indentFirstLine = set.indentFirstLine;
+    if (set.has & PropertySet::HasTabs)           para.tabs.assign(set.tabs.begin(), set.tabs.end());
+}
 
-// -------- ZIP: read multiple files from memory --------
-// Reads multiple files from a ZIP archive in memory
-// @param data: pointer to ZIP data in memory
-// @param size: size of ZIP data
-// @param files: list of filenames to read
-// @return map of filename -> file data
-static std::unordered_map<std::string, std::string>
-readMultipleFilesFromZIPMemory(const char *data,
-                               size_t size,
-                               const std::vector<std::string> &files)
+// Style declaration
+// A style as declared in styles.xml, before inheritance
+struct StyleDecl {
+    ElementType type = ElementType::Paragraph;  // paragraph or run style
+    std::string basedOn;                        // ID of the base style
+    PropertySet properties;                     // properties set by the style itself
+};
+
+using StyleDecls = std::unordered_map<std::string, StyleDecl>;
+
+// Resolved style table
+// Every style of a document with its basedOn chain resolved once, right after
+// parseStyles, and addressed by a dense index. Immutable once built, so the
+// parts of one document read it from several threads without locking.
+struct StyleTable {
+    std::vector<PropertySet> resolved;                  // resolved styles, 0 = empty style
+    std::vector<RunFormat> runFormats;                  // run format of each resolved style
+    std::unordered_map<std::string, uint32_t> index;    // style ID -> index in resolved
+    uint32_t normal = 0;                                // index of the default "Normal" style
+
+    // @param styleId: style ID to look up
+    // @return index of the resolved style, 0 (empty style) if unknown
+    uint32_t find(const std::string &styleId) const
+    {
+        auto it = index.find(styleId);
+        return it != index.end() ? it->second : 0;
+    }
+};
+
+// Style resolution context
+// Owned by a single parse call, so concurrent parses never share mutable state.
+// The parts of one document may share a context from several threads:
+// the style table is read-only and the format table, marked shared, locks
+// internally.
+struct StyleContext {
+    std::shared_ptr<const StyleTable> table;                // keeps the style table alive
+    const StyleTable &styles;                               // resolved styles of the document
+    RunFormatTable formats;                                 // run formats of the document
+    const bool resolveFormatting;                           // false: text only, default formats
+
+    explicit StyleContext(std::shared_ptr<const StyleTable> t, bool formatting = true)
+        : table(std::move(t)), styles(*table), resolveFormatting(formatting) {}
+};
+
+template <template <class> class Alloc>
+static BasicParagraph<Alloc> readParagraph(XMLElement *p, StyleContext &ctx,
+                                           const Alloc<char> &alloc);
+
+// -------------- Resolve styles --------------
+// Resolves every declared style into a StyleTable
+// The basedOn chains are walked iteratively, each style is resolved once by
+// overlaying its own properties on its resolved base.
+// A basedOn link closing a cycle, or naming an unknown style, is ignored.
+// @param styles: styles as declared in styles.xml
+// @return table of resolved styles
+static StyleTable buildStyleTable(const StyleDecls &styles)
 {
-    std::unordered_map<std::string, std::string> out;
-    mz_zip_archive zip;
-    std::memset(&zip, 0, sizeof(zip));
+    StyleTable table;
 
-    if (!mz_zip_reader_init_mem(&zip, data, size, 0))
-        return out;
+    // Dense indices first, so basedOn links can be followed by index
+    std::vector<const StyleDecl *> source(1, nullptr);
+    source.reserve(styles.size() + 1);
+    for (const auto &s : styles)
+    {
+        table.index.emplace(s.first, static_cast<uint32_t>(source.size()));
+        source.push_back(&s.second);
+    }
+    table.resolved.resize(source.size()); // 0 = empty style
 
-    // Iterate through files in the ZIP
-    int n = mz_zip_reader_get_num_files(&zip);
-    for (int i = 0; i < n; ++i)
+    enum class State : uint8_t { Pending, Resolving, Done };
+    std::vector<State> state(source.size(), State::Pending);
+    state[0] = State::Done;
+    std::vector<uint32_t> chain;
+
+    for (uint32_t i = 1; i < source.size(); i++)
     {
-        mz_zip_archive_file_stat st;
-        if (!mz_zip_reader_file_stat(&zip, i, &st))
-            continue;
+        // Walk up the chain until a resolved style, an unknown base or a cycle
+        uint32_t cur = i;
+        while (state[cur] == State::Pending)
+        {
+            state[cur] = State::Resolving;
+            chain.push_back(cur);
+            const std::string &basedOn = source[cur]->basedOn;
+            cur = basedOn.empty() ? 0 : table.find(basedOn);
+        }
+        // A base still being resolved means the chain loops back on itself
+        uint32_t base = state[cur] == State::Done ? cur : 0;
 
-        for (const auto &name : files)
+        // Resolve from the topmost style down
+        while (!chain.empty())
         {
-            if (std::strcmp(st.m_filename, name.c_str()) == 0)
-            {
-                std::string data;
-                data.resize(static_cast<size_t>(st.m_uncomp_size));
-                if (!mz_zip_reader_extract_file_to_mem(
-                        &zip, st.m_filename, data.data(), st.m_uncomp_size, 0))
-                    data.clear();
-                out[name] = std::move(data);
-                break;
-            }
+            uint32_t id = chain.back();
+            chain.pop_back();
+            PropertySet result = table.resolved[base];
+            result.overlay(source[id]->properties);
+            table.resolved[id] = std::move(result);
+            state[id] = State::Done;
+            base = id;
         }
     }
-    mz_zip_reader_end(&zip);
-    return out;
-}
 
+    // Run formats of the styles, so runs only apply their direct properties
+    table.runFormats.resize(table.resolved.size());
+    for (size_t i = 0; i < table.resolved.size(); i++)
+        applyRunProperties(table.runFormats[i], table.resolved[i]);
 
-// ---------------- Styles parsing ----------------
-// Parses styles.xml and returns a map of styleId -> Style
-// @param xml: styles.xml content
-// @return map of styleId -> Style
-static StyleMap parseStyles(const std::string &xml)
-{
-    StyleMap map;
-    if (xml.empty())
-        return map;
+    table.normal = table.find("Normal");
+    return table;
+}
 
-    XMLDocument doc;
-    doc.Parse(xml.c_str());
-    XMLElement *root = doc.FirstChildElement("w:styles");
-    if (!root)
-        return map;
+// @return the table of a document without styles, shared by the parses
+//         that skip styles.xml
+static std::shared_ptr<const StyleTable> emptyStyleTable()
+{
+    static const std::shared_ptr<const StyleTable> table =
+        std::make_shared<const StyleTable>(buildStyleTable(StyleDecls()));
+    return table;
+}
 
-    // Parse each style
-    for (XMLElement *s = root->FirstChildElement("w:style"); s;
-         s = s->NextSiblingElement("w:style"))
+// Parsed styles structure
+// styles.xml of one document, as parsed and as resolved
+struct ParsedStyles {
+    StyleMap map;                                   // styles as parsed
+    std::shared_ptr<const StyleTable> table;        // resolved styles
+};
+
+// Shared style cache
+// Parsed styles.xml parts shared across documents, keyed by the CRC32 and
+// size of the part from the ZIP central directory, so a known template is
+// neither inflated nor parsed again. Bounded, least recently used entries
+// are evicted first.
+struct StyleCache {
+    using Key = uint64_t;
+    using Entry = std::pair<Key, std::shared_ptr<const ParsedStyles>>;
+
+    size_t capacity;                                        // maximum number of entries
+    std::mutex mutex;                                       // guards lru and entries
+    std::list<Entry> lru;                                   // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator> entries; // key -> node in lru
+
+    explicit StyleCache(size_t cap) : capacity(cap) {}
+
+    // @param key: key of the styles part
+    // @return cached styles, null if not cached
+    std::shared_ptr<const ParsedStyles> find(Key key)
     {
-        const char *id = s->Attribute("w:styleId");
-        if (!id)
-            continue;
-
-        Style st;
-        if (const char *t = s->Attribute("w:type"))
-            st.styleType =
-                (std::strcmp(t, "paragraph") == 0) ? ElementType::Paragraph : ElementType::Run;
-
-        // Based on
-        if (XMLElement *b = s->FirstChildElement("w:basedOn"))
-            if (b->Attribute("w:val"))
-                st.basedOn = b->Attribute("w:val");
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return nullptr;
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+    }
 
-        // Run properties
-        if (XMLElement *rPr = s->FirstChildElement("w:rPr"))
+    // Adds styles; another thread may have added the same key meanwhile
+    // @param key: key of the styles part
+    // @param styles: parsed styles
+    void insert(Key key, std::shared_ptr<const ParsedStyles> styles)
+    {
+        if (capacity == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.count(key))
+            return;
+        lru.emplace_front(key, std::move(styles));
+        entries.emplace(key, lru.begin());
+        if (lru.size() > capacity)
         {
-            // Character properties
-            if (rPr->FirstChildElement("w:b"))
-                st.bold = true;
-            if (rPr->FirstChildElement("w:i"))
-                st.italic = true;
-            if (rPr->FirstChildElement("w:u"))
-                st.underline = true;
-            if (rPr->FirstChildElement("w:strike"))
-                st.strikeThrough = true;
-            if (rPr->FirstChildElement("w:subscript"))
-                st.Subscript = true;
-            if (rPr->FirstChildElement("w:superscript"))
-                st.Superscript = true;
-
-            // Colors and font
-            if (XMLElement *c = rPr->FirstChildElement("w:color"))
-                if (c->Attribute("w:val"))
-                    st.color = Color(c->Attribute("w:val"));
-            if (XMLElement *sh = rPr->FirstChildElement("w:shd"))
-                if (sh->Attribute("w:fill"))
-                    st.backColor = Color(sh->Attribute("w:fill"));
-            if (XMLElement *rf = rPr->FirstChildElement("w:rFonts"))
-                if (rf->Attribute("w:ascii"))
-                    st.fontFamily = rf->Attribute("w:ascii");
-            if (XMLElement *sz = rPr->FirstChildElement("w:sz"))
-                if (sz->Attribute("w:val"))
-                    st.fontSize = std::stof(sz->Attribute("w:val")) / 2.0f;
-        }
-
-        // Paragraph properties
-        if (XMLElement *pPr = s->FirstChildElement("w:pPr"))
+            entries.erase(lru.back().first);
+            lru.pop_back();
+        }
+    }
+};
+
+
+// -------- Memory-mapped file --------
+// Read-only memory mapping of a whole file
+// The mapping is shared with the page cache, so no copy of the file is made
+// and processes reading the same file share its pages.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps a file into memory
+    // @param path: path to the file
+    // @return true on success
+    bool open(const std::string &path)
+    {
+        close();
+#if defined(MINIDOCKLIB_PLATFORM_WINDOWS)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
         {
-
-            // level
-            if (XMLElement *outline = pPr->FirstChildElement("w:outlineLvl"))
-                if (outline->Attribute("w:val"))
-                    st.level = std::atoi(outline->Attribute("w:val"));
-            // Numbering
-            if (XMLElement *num = pPr->FirstChildElement("w:numPr"))
-            {
-                // Numbering ID
-                if (XMLElement *numId = num->FirstChildElement("w:numId"))
-                    if (numId->Attribute("w:val"))
-                        st.numberFormat = "decimal"; // Default format
-                // Level
-                if (XMLElement *ilvl = num->FirstChildElement("w:ilvl"))
-                    if (ilvl->Attribute("w:val"))
-                        st.level = std::atoi(ilvl->Attribute("w:val"));
-                // Style
-                if (XMLElement *numStyle = num->FirstChildElement("w:numStyle"))
-                    if (numStyle->Attribute("w:val"))
-                        st.numberStyle = numStyle->Attribute("w:val");
-                st.numbered = true;
-            }
-            // Spacing
-            if (XMLElement *sp = pPr->FirstChildElement("w:spacing"))
-            {
-                if (sp->Attribute("w:line"))
-                    st.lineSpacing = std::stof(sp->Attribute("w:line")) / 240.0f;
-                if (sp->Attribute("w:before"))
-                    st.spaceBefore = std::stof(sp->Attribute("w:before")) / 20.0f;
-                if (sp->Attribute("w:after"))
-                    st.spaceAfter = std::stof(sp->Attribute("w:after")) / 20.0f;
-                if (sp->Attribute("w:lineRule"))
-                {
-                    const char *val = sp->Attribute("w:lineRule");
-                    if (std::strcmp(val, "exact") == 0)
-                        st.spaceBetweenSameStyle = true;
-                }
-            }
-            // Indentation
-            if (XMLElement *indent = pPr->FirstChildElement("w:ind"))
-            {
-                if (indent->Attribute("w:left"))
-                    st.indentLeft = std::stof(indent->Attribute("w:left")) / 20.0f;
-                if (indent->Attribute("w:right"))
-                    st.indentRight = std::stof(indent->Attribute("w:right")) / 20.0f;
-                if (indent->Attribute("w:firstLine"))
-                    st.indentFirstLine = std::stof(indent->Attribute("w:firstLine")) / 20.0f;
-            }
-            // Justification
-            if (XMLElement *jc = pPr->FirstChildElement("w:jc"))
-            {
-                if (const char *val = jc->Attribute("w:val"))
-                {
-                    if (std::strcmp(val, "center") == 0)
-                        st.justification = Justification::Center;
-                    else if (std::strcmp(val, "right") == 0)
-                        st.justification = Justification::Right;
-                    else if (std::strcmp(val, "both") == 0)
-                        st.justification = Justification::Justify;
-                }
-            }
-            // Tabs
-            if (XMLElement *tabs = pPr->FirstChildElement("w:tabs"))
-            {
-                for (XMLElement *tab = tabs->FirstChildElement("w:tab"); tab;
-                     tab = tab->NextSiblingElement("w:tab"))
-                {
-                    Tab t;
-                    if (tab->Attribute("w:pos"))
-                        t.position = std::stof(tab->Attribute("w:pos")) / 20.0f;
-                    if (tab->Attribute("w:val"))
-                        t.alignment = tab->Attribute("w:val")[0]; // L, C, R, D
-                    if (tab->Attribute("w:leader"))
-                        t.leader = tab->Attribute("w:leader");
-                    st.tabs.emplace_back(std::move(t));
-                }
-            }
-            // Bidi
-            if (XMLElement *bd = pPr->FirstChildElement("w:bidi"))
-                st.rightDirection = true;
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+        void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view)
+            return false;
+        data_ = static_cast<const char *>(view);
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
         }
+        void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED)
+            return false;
+        // Parts are inflated front to back
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(view);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
 
-        // add the new style to the map
-        map.emplace(id, std::move(st));
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void close()
+    {
+        if (!data_)
+            return;
+#if defined(MINIDOCKLIB_PLATFORM_WINDOWS)
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<char *>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
     }
 
-    return map;
-}
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+
+// -------- ZIP: indexed archive --------
+// Opened ZIP archive with a hashed index of its central directory
+// The index is built in one pass when the archive is opened, so every part
+// lookup is a single hash probe and extraction goes straight to the entry.
+// Extraction may run from several threads; reads of file archives are
+// serialized, decompression is not.
+class ZipArchive {
+public:
+    ZipArchive() { std::memset(&zip_, 0, sizeof(zip_)); }
+    ~ZipArchive() { close(); }
+    ZipArchive(const ZipArchive &) = delete;
+    ZipArchive &operator=(const ZipArchive &) = delete;
+
+    // Opens a ZIP archive from a file path
+    // @param path: path to ZIP file
+    // @return true on success
+    bool openFile(const std::string &path)
+    {
+        close();
+        if (!mz_zip_reader_init_file(&zip_, path.c_str(), MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY))
+            return false;
+        // Route file reads through a lock, the FILE* position is shared
+        baseRead_ = zip_.m_pRead;
+        baseOpaque_ = zip_.m_pIO_opaque;
+        zip_.m_pRead = &ZipArchive::lockedRead;
+        zip_.m_pIO_opaque = this;
+        open_ = true;
+        buildIndex();
+        return true;
+    }
 
+    // Opens a ZIP archive from memory
+    // @param data: pointer to ZIP data in memory, must outlive the archive
+    // @param size: size of ZIP data
+    // @return true on success
+    bool openMemory(const char *data, size_t size)
+    {
+        close();
+        if (!mz_zip_reader_init_mem(&zip_, data, size, MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY))
+            return false;
+        open_ = true;
+        buildIndex();
+        return true;
+    }
 
-// ------------ Parse Footnotes -------------
-// Parses footnotes.xml and returns a map of footnote ID -> text
-// @param xml: footnotes.xml content
-// @return map of footnote ID -> text
-// @todo: handle complex footnotes with multiple paragraphs, etc.
-// For now, we just collect plain text
-// @todo: support footnotes with styles
-static std::unordered_map<int, Note> parseFootnotes(const std::string &xml, 
-                                                    const StyleMap &styles)
-{
-    std::unordered_map<int, Note> map;
-    if (xml.empty())
-        return map;
+    bool isOpen() const { return open_; }
 
-    XMLDocument doc;
-    doc.Parse(xml.c_str());
+    // Looks up an entry in the central directory index
+    // @param name: entry name
+    // @return file index of the entry, or -1 if not found
+    int find(const std::string &name) const
+    {
+        auto it = index_.find(name);
+        return it == index_.end() ? -1 : static_cast<int>(it->second);
+    }
 
-    XMLElement *root = doc.FirstChildElement("w:footnotes");
-    if (!root)
-        return map;
+    // @param fileIndex: file index of the entry
+    // @return uncompressed size of the entry, 0 if not found
+    size_t size(int fileIndex)
+    {
+        mz_zip_archive_file_stat st;
+        if (fileIndex < 0 || !mz_zip_reader_file_stat(&zip_, static_cast<mz_uint>(fileIndex), &st))
+            return 0;
+        return static_cast<size_t>(st.m_uncomp_size);
+    }
 
-    // Parse each footnote
-    for (XMLElement *fn = root->FirstChildElement("w:footnote"); fn;
-         fn = fn->NextSiblingElement("w:footnote"))
+    // Reads the CRC32 and size of an entry from the central directory
+    // @param fileIndex: file index of the entry
+    // @param crc32: receives the CRC32 of the uncompressed data
+    // @param size: receives the uncompressed size
+    // @return true if the entry exists
+    bool stat(int fileIndex, uint32_t &crc32, size_t &size)
     {
-        const char *idAttr = fn->Attribute("w:id");
-        if (!idAttr)
-            continue;
-        int id = std::atoi(idAttr);
+        mz_zip_archive_file_stat st;
+        if (fileIndex < 0 || !mz_zip_reader_file_stat(&zip_, static_cast<mz_uint>(fileIndex), &st))
+            return false;
+        crc32 = st.m_crc32;
+        size = static_cast<size_t>(st.m_uncomp_size);
+        return true;
+    }
 
-        // Skip separator footnotes
-        const char *typeAttr = fn->Attribute("w:type");
-        if (typeAttr &&
-            (std::strcmp(typeAttr, "separator") == 0 ||
-             std::strcmp(typeAttr, "continuationSeparator") == 0))
+    // Extracts an entry by file index
+    // @param fileIndex: file index of the entry
+    // @param out: receives the uncompressed data
+    // @return true on success
+    bool extract(int fileIndex, std::string &out)
+    {
+        out.clear();
+        mz_zip_archive_file_stat st;
+        if (fileIndex < 0 || !mz_zip_reader_file_stat(&zip_, static_cast<mz_uint>(fileIndex), &st))
+            return false;
+        out.resize(static_cast<size_t>(st.m_uncomp_size));
+        if (!mz_zip_reader_extract_to_mem(&zip_, static_cast<mz_uint>(fileIndex),
+                                          &out[0], out.size(), 0))
         {
-            continue; // skip separators
+            out.clear();
+            return false;
         }
+        return true;
+    }
 
-        // For now, get the styled text
-        std::vector<Paragraph> paragraphs;
-        // Collect paragraphs
-        for (XMLElement *p = fn->FirstChildElement("w:p"); p;
-             p = p->NextSiblingElement("w:p"))
+    // Extracts an entry by name
+    // @param name: entry name
+    // @param out: receives the uncompressed data
+    // @return true on success
+    bool extract(const std::string &name, std::string &out)
+    {
+        return extract(find(name), out);
+    }
+
+    // Inflates an entry chunk by chunk
+    // miniz inflates into its 32 KB dictionary ring buffer and hands over
+    // each filled chunk, so the entry is never held in memory as a whole.
+    // @param fileIndex: file index of the entry
+    // @param onChunk: receives each inflated chunk; return false to stop
+    // @return true if the whole entry was inflated
+    bool stream(int fileIndex, const std::function<bool(const char *, size_t)> &onChunk)
+    {
+        if (fileIndex < 0)
+            return false;
+        return mz_zip_reader_extract_to_callback(&zip_, static_cast<mz_uint>(fileIndex),
+                                                 &ZipArchive::chunkWritten,
+                                                 const_cast<void *>(static_cast<const void *>(&onChunk)),
+                                                 0) != 0;
+    }
+
+private:
+    // Indexes every entry name of the central directory
+    void buildIndex()
+    {
+        mz_uint n = mz_zip_reader_get_num_files(&zip_);
+        index_.reserve(n);
+        std::string name;
+        for (mz_uint i = 0; i < n; ++i)
         {
-            Paragraph para = readParagraph(p, styles);
-            paragraphs.emplace_back(std::move(para));
+            mz_uint len = mz_zip_reader_get_filename(&zip_, i, nullptr, 0);
+            if (len <= 1)
+                continue;
+            name.resize(len);
+            mz_zip_reader_get_filename(&zip_, i, &name[0], len);
+            name.resize(len - 1);
+            index_.emplace(name, i);
         }
-        
-        // Add to map
-        map[id] = Note{id, std::move(paragraphs)};
     }
 
-    return map;
-}
+    void close()
+    {
+        if (open_)
+            mz_zip_reader_end(&zip_);
+        std::memset(&zip_, 0, sizeof(zip_));
+        index_.clear();
+        open_ = false;
+    }
+
+    static size_t chunkWritten(void *opaque, mz_uint64, const void *buf, size_t n)
+    {
+        auto &onChunk = *static_cast<const std::function<bool(const char *, size_t)> *>(opaque);
+        return onChunk(static_cast<const char *>(buf), n) ? n : 0;
+    }
 
+    static size_t lockedRead(void *opaque, mz_uint64 ofs, void *buf, size_t n)
+    {
+        ZipArchive *self = static_cast<ZipArchive *>(opaque);
+        std::lock_guard<std::mutex> lock(self->readMutex_);
+        return self->baseRead_(self->baseOpaque_, ofs, buf, n);
+    }
 
-// ------------ Parse Endnotes -------------
-// Parses endnotes.xml and returns a map of endnote ID -> text
-// @param xml: endnotes.xml content
-// @return map of endnote ID -> text
-static std::unordered_map<int, Note> parseEndnotes(const std::string &xml, 
-                                                   const StyleMap &styles)
+    mz_zip_archive zip_;
+    bool open_ = false;
+    std::unordered_map<std::string, mz_uint> index_;    // entry name -> file index
+    mz_file_read_func baseRead_ = nullptr;              // miniz file reader
+    void *baseOpaque_ = nullptr;
+    std::mutex readMutex_;
+};
+
+
+// ------------ Parse XML in place -------------
+// Parses a decompressed part directly in its buffer
+// tinyxml2 would otherwise copy the whole part into its own buffer first.
+// The nodes point into the buffer, so it must outlive the XMLDocument.
+// @param doc: XML document to parse into
+// @param xml: part content, modified by the parser
+static void parseXmlInPlace(XMLDocument &doc, std::string &xml)
 {
-    std::unordered_map<int, Note> map;
-    if (xml.empty())
-        return map;
-
-    XMLDocument doc;
-    doc.Parse(xml.c_str());
+    doc.ParseInPlace(&xml[0], xml.size());
+}
 
-    XMLElement *root = doc.FirstChildElement("w:endnotes");
-    if (!root)
-        return map;
 
-    // Parse each endnote
-    for (XMLElement *en = root->FirstChildElement("w:endnote"); en;
-         en = en->NextSiblingElement("w:endnote"))
-    {
-        const char *idAttr = en->Attribute("w:id");
-        if (!idAttr)
-            continue;
-        int id = std::atoi(idAttr);
+// ---------------- Attribute values ----------------
+// Numbers are read with std::from_chars: locale-independent, allocation-free
+// and non-throwing. Like std::stof, a value is read up to the first character
+// that is not part of the number. A malformed or out-of-range value is
+// reported by returning false, and the property keeps its previous value.
 
-        // Skip separator endnotes
-        const char *typeAttr = en->Attribute("w:type");
-        if (typeAttr &&
-            (std::strcmp(typeAttr, "separator") == 0 ||
-             std::strcmp(typeAttr, "continuationSeparator") == 0))
-        {
-            continue; // skip separators
-        }
+// @param text: attribute value, may be null
+// @param value: receives the number
+// @return false if the value does not start with a valid number
+template <class T>
+static bool parseNumber(const char *text, T &value)
+{
+    if (!text)
+        return false;
+    while (*text == ' ')
+        ++text;
+    if (*text == '+')
+        ++text;
+    return std::from_chars(text, text + std::strlen(text), value).ec == std::errc();
+}
 
-        // For now, get the styled text
-        std::vector<Paragraph> paragraphs;
-        // Collect paragraphs
-        for (XMLElement *p = en->FirstChildElement("w:p"); p;
-             p = p->NextSiblingElement("w:p"))
-        {
-            Paragraph para = readParagraph(p, styles);
-            paragraphs.emplace_back(std::move(para));
-        }
-        
-        // Add to map
-        map[id] = Note{id, std::move(paragraphs)};
-    }
+// @param text: attribute value, may be null
+// @param unitsPerPoint: units of the attribute per resulting unit
+// @param value: receives the scaled number
+// @return false if the value is malformed
+static bool parseScaled(const char *text, float unitsPerPoint, float &value)
+{
+    float raw;
+    if (!parseNumber(text, raw))
+        return false;
+    value = raw / unitsPerPoint;
+    return true;
+}
 
-    return map;
+// Twentieths of a point, e.g. indentation and spacing, to points
+static bool parseTwips(const char *text, float &points)
+{
+    return parseScaled(text, 20.0f, points);
 }
 
+// Half-points, e.g. font sizes, to points
+static bool parseHalfPoints(const char *text, float &points)
+{
+    return parseScaled(text, 2.0f, points);
+}
 
-// ------------ Compare Run Styles -------------
-// Compares two runs to see if they have the same style
-// @param a: first Run
-// @param b: second Run
-// @return true if styles are the same, false otherwise
-static bool sameRunStyle(const Run &a, const Run &b)
+// 240ths of a line, e.g. line spacing, to lines
+static bool parseLineUnits(const char *text, float &lines)
 {
-    return a.style == b.style &&
-           a.lang == b.lang &&
-           a.bold == b.bold &&
-           a.italic == b.italic &&
-           a.underline == b.underline &&
-           a.strike == b.strike &&
-           a.color == b.color &&
-           a.backColor == b.backColor &&
-           a.fontFamily == b.fontFamily &&
-           a.fontSize == b.fontSize &&
-           a.subscript == b.subscript &&
-           a.superscript == b.superscript;
+    return parseScaled(text, 240.0f, lines);
 }
 
 
-// ------------ Merge Adjacent Runs -------------
-// Merges adjacent runs with the same style
-// @param runs: vector of Runs to merge
-static void mergeAdjacentRuns(std::vector<Run> &runs)
+// ---------------- WordprocessingML property tags ----------------
+// Child elements of w:rPr, w:pPr and w:numPr recognized by the readers
+enum class Tag : uint8_t {
+    Unknown,
+    // run properties
+    RStyle, Lang, B, I, U, Strike, Subscript, Superscript, Color, Shd, RFonts, Sz,
+    // paragraph properties
+    PStyle, OutlineLvl, NumPr, Spacing, Ind, Jc, Tabs, Bidi,
+    // numbering properties
+    NumId, Ilvl, NumStyle,
+    Count
+};
+
+// FNV-1a hash of an element name, usable in case labels
+// @param name: element name
+// @return 32-bit hash
+constexpr uint32_t tagHash(const char *name)
 {
-    if (runs.size() < 2)
-        return;
+    uint32_t h = 2166136261u;
+    for (; *name; ++name)
+        h = (h ^ static_cast<uint8_t>(*name)) * 16777619u;
+    return h;
+}
 
-    std::vector<Run> merged;
-    merged.emplace_back(std::move(runs[0]));
+// @return tag if name is the expected name, Tag::Unknown otherwise
+static inline Tag tagIf(const char *name, const char *expected, Tag tag)
+{
+    return std::strcmp(name, expected) == 0 ? tag : Tag::Unknown;
+}
 
-    for (size_t i = 1; i < runs.size(); ++i)
+// Maps an element name to its property tag
+// The hash selects the only candidate in one switch; the compare rules out
+// unrecognized names colliding with it. Two recognized names colliding
+// would not compile (duplicate case label).
+// @param name: element name
+// @return tag of the element, Tag::Unknown if not recognized
+static Tag tagOf(const char *name)
+{
+    switch (tagHash(name))
     {
-        if (sameRunStyle(merged.back(), runs[i]))
-        {
-            merged.back().text += runs[i].text;
-        }
-        else
-        {
-            merged.emplace_back(std::move(runs[i]));
-        }
+    case tagHash("w:rStyle"):       return tagIf(name, "w:rStyle", Tag::RStyle);
+    case tagHash("w:lang"):         return tagIf(name, "w:lang", Tag::Lang);
+    case tagHash("w:b"):            return tagIf(name, "w:b", Tag::B);
+    case tagHash("w:i"):            return tagIf(name, "w:i", Tag::I);
+    case tagHash("w:u"):            return tagIf(name, "w:u", Tag::U);
+    case tagHash("w:strike"):       return tagIf(name, "w:strike", Tag::Strike);
+    case tagHash("w:subscript"):    return tagIf(name, "w:subscript", Tag::Subscript);
+    case tagHash("w:superscript"):  return tagIf(name, "w:superscript", Tag::Superscript);
+    case tagHash("w:color"):        return tagIf(name, "w:color", Tag::Color);
+    case tagHash("w:shd"):          return tagIf(name, "w:shd", Tag::Shd);
+    case tagHash("w:rFonts"):       return tagIf(name, "w:rFonts", Tag::RFonts);
+    case tagHash("w:sz"):           return tagIf(name, "w:sz", Tag::Sz);
+    case tagHash("w:pStyle"):       return tagIf(name, "w:pStyle", Tag::PStyle);
+    case tagHash("w:outlineLvl"):   return tagIf(name, "w:outlineLvl", Tag::OutlineLvl);
+    case tagHash("w:numPr"):        return tagIf(name, "w:numPr", Tag::NumPr);
+    case tagHash("w:spacing"):      return tagIf(name, "w:spacing", Tag::Spacing);
+    case tagHash("w:ind"):          return tagIf(name, "w:ind", Tag::Ind);
+    case tagHash("w:jc"):           return tagIf(name, "w:jc", Tag::Jc);
+    case tagHash("w:tabs"):         return tagIf(name, "w:tabs", Tag::Tabs);
+    case tagHash("w:bidi"):         return tagIf(name, "w:bidi", Tag::Bidi);
+    case tagHash("w:numId"):        return tagIf(name, "w:numId", Tag::NumId);
+    case tagHash("w:ilvl"):         return tagIf(name, "w:ilvl", Tag::Ilvl);
+    case tagHash("w:numStyle"):     return tagIf(name, "w:numStyle", Tag::NumStyle);
+    default:                        return Tag::Unknown;
     }
+}
 
-    runs = std::move(merged);
+// ---------------- Property decoding ----------------
+// One decoder per recognized property element, indexed by its tag, fills the
+// property set; w:rPr, w:pPr and w:numPr are decoded in a single pass over
+// their children, for styles and direct formatting alike.
+
+using PropertyDecoder = void (*)(XMLElement *e, PropertySet &set);
+
+static XMLElement *decodeProperties(XMLElement *parent, PropertySet &set);
+
+// @return value of an on/off property: on unless w:val is 0, false or off
+static bool readToggle(XMLElement *e)
+{
+    const char *val = e->Attribute("w:val");
+    return !val || !(std::strcmp(val, "0") == 0 || std::strcmp(val, "false") == 0 ||
+                     std::strcmp(val, "off") == 0);
 }
 
+// Reads a string property
+// @param val: attribute value, may be null
+// @param bit: Has* bit of the property
+// @param set: property set
+// @param out: receives the value
+static void readString(const char *val, uint32_t bit, PropertySet &set, std::string &out)
+{
+    if (!val)
+        return;
+    out = val;
+    set.has |= bit;
+}
 
-// ------------ Read Paragraph -------------
-// Reads a paragraph from an XML element
-// @param p: XML element representing the paragraph
-// @param styles: map of styleId -> Style
-// @return Paragraph object
-static Paragraph readParagraph(XMLElement *p,
-                               const StyleMap &styles)
+// Reads a measurement property
+// @param ok: result of the parse of the value
+// @param bit: Has* bit of the property
+// @param set: property set
+static void readMeasure(bool ok, uint32_t bit, PropertySet &set)
 {
-    Paragraph para;
-    std::string pStyleId;
+    if (ok)
+        set.has |= bit;
+}
 
-    if (XMLElement *pPr = p->FirstChildElement("w:pPr"))
+// @return the decoder table, indexed by Tag
+static const PropertyDecoder *propertyDecoders()
+{
+    static const auto table = []
     {
-        if (XMLElement *pStyle = pPr->FirstChildElement("w:pStyle"))
+        std::array<PropertyDecoder, static_cast<size_t>(Tag::Count)> t{};
+        auto at = [&t](Tag tag) -> PropertyDecoder & { return t[static_cast<size_t>(tag)]; };
+
+        // run properties
+        at(Tag::B) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasBold, readToggle(e)); };
+        at(Tag::I) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasItalic, readToggle(e)); };
+        at(Tag::U) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasUnderline, readToggle(e)); };
+        at(Tag::Strike) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasStrike, readToggle(e)); };
+        at(Tag::Subscript) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasSubscript, readToggle(e)); };
+        at(Tag::Superscript) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasSuperscript, readToggle(e)); };
+        at(Tag::Color) = [](XMLElement *e, PropertySet &s)
         {
-            if (pStyle->Attribute("w:val"))
-                pStyleId = pStyle->Attribute("w:val");
-        }
-
-        // Copy the styles from the paragraph style
-        Style paraStyle = mergeStyleCached(styles, pStyleId.empty() ? "Normal" : pStyleId);
-        // numbering
-        para.numbered = paraStyle.numbered;
-        para.numberFormat = paraStyle.numberFormat;
-        para.numberStyle = paraStyle.numberStyle;
-        para.level = paraStyle.level;
-        // Justification
-        para.justification = paraStyle.justification;
-        // bidi
-        para.rightDirection = paraStyle.rightDirection;
-        // indentation
-        para.style = pStyleId;
-        if (paraStyle.lineSpacing > 0.0f)
-            para.lineSpacing = paraStyle.lineSpacing;
-        para.spaceBefore = paraStyle.spaceBefore;
-        para.spaceAfter = paraStyle.spaceAfter;
-        para.spaceBetweenSameStyle = paraStyle.spaceBetweenSameStyle;
-        // spacing
-        para.indentLeft = paraStyle.indentLeft;
-        para.indentRight = paraStyle.indentRight;
-        para.indentFirstLine = paraStyle.indentFirstLine;
-        // Tabs
-        para.tabs = paraStyle.tabs;
-
-        // Now, override with direct properties
-        // Numbering
-        if (XMLElement *numPr = pPr->FirstChildElement("w:numPr"))
-        {
-            para.numbered = true;
-            // Numbering ID
-            if (XMLElement *numId = numPr->FirstChildElement("w:numId"))
-                if (numId->Attribute("w:val"))
-                    para.numberFormat = "decimal"; // Default format
-            // Level
-            if (XMLElement *ilvl = numPr->FirstChildElement("w:ilvl"))
-                if (ilvl->Attribute("w:val"))
-                    para.level = std::atoi(ilvl->Attribute("w:val"));
-            // Style
-            if (XMLElement *numStyle = numPr->FirstChildElement("w:numStyle"))
-                if (numStyle->Attribute("w:val"))
-                    para.numberStyle = numStyle->Attribute("w:val");
-        }
-
-        // Justification
-        if (XMLElement *jc = pPr->FirstChildElement("w:jc"))
-        {
-            if (const char *val = jc->Attribute("w:val"))
-            {
-                if (std::strcmp(val, "center") == 0)
-                    para.justification = Justification::Center;
-                else if (std::strcmp(val, "right") == 0)
-                    para.justification = Justification::Right;
-                else if (std::strcmp(val, "both") == 0)
-                    para.justification = Justification::Justify;
-            }
-        }
-        // Bidi
-        if (XMLElement *bd = pPr->FirstChildElement("w:bidi"))
-            para.rightDirection = true;
-
-        // Indentation
-        if (XMLElement *indent = pPr->FirstChildElement("w:ind"))
-        {
-            if (indent->Attribute("w:left"))
-                para.indentLeft = std::stof(indent->Attribute("w:left")) / 20.0f;
-            if (indent->Attribute("w:right"))
-                para.indentRight = std::stof(indent->Attribute("w:right")) / 20.0f;
-            if (indent->Attribute("w:firstLine"))
-                para.indentFirstLine = std::stof(indent->Attribute("w:firstLine")) / 20.0f;
-        }
-
-        // Spacing
-        if (XMLElement *spacing = pPr->FirstChildElement("w:spacing"))
-        {
-            if (spacing->Attribute("w:line"))
-                para.lineSpacing = std::stof(spacing->Attribute("w:line")) / 240.0f;
-            if (spacing->Attribute("w:before"))
-                para.spaceBefore = std::stof(spacing->Attribute("w:before")) / 20.0f;
-            if (spacing->Attribute("w:after"))
-                para.spaceAfter = std::stof(spacing->Attribute("w:after")) / 20.0f;
-            if (spacing->Attribute("w:lineRule"))
-            {
-                const char *val = spacing->Attribute("w:lineRule");
-                if (std::strcmp(val, "exact") == 0)
-                    para.spaceBetweenSameStyle = true;
-            }
-        }
-
-        // Tabs
-        if (XMLElement *tabs = pPr->FirstChildElement("w:tabs"))
-        {
-            para.tabs.clear();
-            for (XMLElement *tab = tabs->FirstChildElement("w:tab"); tab;
+            if (const char *val = e->Attribute("w:val"))
+            {
+                s.color = Color(val);
+                s.has |= PropertySet::HasColor;
+            }
+        };
+        at(Tag::Shd) = [](XMLElement *e, PropertySet &s)
+        {
+            if (const char *fill = e->Attribute("w:fill"))
+            {
+                s.backColor = Color(fill);
+                s.has |= PropertySet::HasBackColor;
+            }
+        };
+        at(Tag::RFonts) = [](XMLElement *e, PropertySet &s)
+        {
+            readString(e->Attribute("w:ascii"), PropertySet::HasFontFamily, s, s.fontFamily);
+        };
+        at(Tag::Sz) = [](XMLElement *e, PropertySet &s)
+        {
+            readMeasure(parseHalfPoints(e->Attribute("w:val"), s.fontSize), PropertySet::HasFontSize, s);
+        };
+        at(Tag::Lang) = [](XMLElement *e, PropertySet &s)
+        {
+            readString(e->Attribute("w:val"), PropertySet::HasLang, s, s.lang);
+        };
+
+        // paragraph properties
+        at(Tag::OutlineLvl) = [](XMLElement *e, PropertySet &s)
+        {
+            // The numbering level takes precedence
+            if (!(s.has & PropertySet::HasLevel) && e->Attribute("w:val"))
+            {
+                s.level = std::atoi(e->Attribute("w:val"));
+                s.has |= PropertySet::HasLevel;
+            }
+        };
+        at(Tag::NumPr) = [](XMLElement *e, PropertySet &s)
+        {
+            s.setFlag(PropertySet::HasNumbered, true);
+            decodeProperties(e, s);
+        };
+        at(Tag::Spacing) = [](XMLElement *e, PropertySet &s)
+        {
+            readMeasure(parseLineUnits(e->Attribute("w:line"), s.lineSpacing), PropertySet::HasLineSpacing, s);
+            readMeasure(parseTwips(e->Attribute("w:before"), s.spaceBefore), PropertySet::HasSpaceBefore, s);
+            readMeasure(parseTwips(e->Attribute("w:after"), s.spaceAfter), PropertySet::HasSpaceAfter, s);
+            if (const char *rule = e->Attribute("w:lineRule"))
+                s.setFlag(PropertySet::HasExactSpacing, std::strcmp(rule, "exact") == 0);
+        };
+        at(Tag::Ind) = [](XMLElement *e, PropertySet &s)
+        {
+            readMeasure(parseTwips(e->Attribute("w:left"), s.indentLeft), PropertySet::HasIndentLeft, s);
+            readMeasure(parseTwips(e->Attribute("w:right"), s.indentRight), PropertySet::HasIndentRight, s);
+            readMeasure(parseTwips(e->Attribute("w:firstLine"), s.indentFirstLine), PropertySet::HasIndentFirstLine, s);
+        };
+        at(Tag::Jc) = [](XMLElement *e, PropertySet &s)
+        {
+            const char *val = e->Attribute("w:val");
+            if (!val)
+                return;
+            if (std::strcmp(val, "left") == 0 || std::strcmp(val, "start") == 0)
+                s.justification = Justification::Left;
+            else if (std::strcmp(val, "center") == 0)
+                s.justification = Justification::Center;
+            else if (std::strcmp(val, "right") == 0 || std::strcmp(val, "end") == 0)
+                s.justification = Justification::Right;
+            else if (std::strcmp(val, "both") == 0)
+                s.justification = Justification::Justify;
+            else
+                return;
+            s.has |= PropertySet::HasJustification;
+        };
+        at(Tag::Tabs) = [](XMLElement *e, PropertySet &s)
+        {
+            s.tabs.clear();
+            for (XMLElement *tab = e->FirstChildElement("w:tab"); tab;
                  tab = tab->NextSiblingElement("w:tab"))
             {
                 Tab t;
-                if (tab->Attribute("w:pos"))
-                    t.position = std::stof(tab->Attribute("w:pos")) / 20.0f;
+                parseTwips(tab->Attribute("w:pos"), t.position);
                 if (tab->Attribute("w:val"))
                     t.alignment = tab->Attribute("w:val")[0]; // L, C, R, D
                 if (tab->Attribute("w:leader"))
                     t.leader = tab->Attribute("w:leader");
-                para.tabs.emplace_back(std::move(t));
+                s.tabs.emplace_back(std::move(t));
             }
-        }
-    }
+            s.has |= PropertySet::HasTabs;
+        };
+        at(Tag::Bidi) = [](XMLElement *e, PropertySet &s) { s.setFlag(PropertySet::HasRightDirection, readToggle(e)); };
 
-    // Paragraph style
-    if (pStyleId.empty()){
-        pStyleId = "Normal"; // default style
-    }
-    Style paraStyle = mergeStyleCached(styles, pStyleId);
-
-    // Now, parse runs
-    // Each run may override the paragraph style
-    for (XMLElement *r = p->FirstChildElement("w:r"); r;
-         r = r->NextSiblingElement("w:r"))
-    {
-        // Footnote reference always creates a new run
-        if (XMLElement *fr = r->FirstChildElement("w:footnoteReference"))
+        // numbering properties
+        at(Tag::NumId) = [](XMLElement *e, PropertySet &s)
         {
-            if (fr->Attribute("w:id"))
+            if (e->Attribute("w:val"))
             {
-                int id = std::atoi(fr->Attribute("w:id"));
-                Run run;
-                run.noteId = id;
-                run.text = fr->GetText() ? fr->GetText() : "";
-                para.runs.emplace_back(std::move(run));
-                continue;
+                s.numberFormat = "decimal"; // Default format
+                s.has |= PropertySet::HasNumberFormat;
             }
-        }
-
-        Run run;
-        std::string rStyleId;
-        // Text
-        if (XMLElement *t = r->FirstChildElement("w:t"))
-        {
-            if (t->GetText())
-                run.text = t->GetText();
-        }
-        // Handle xml:space="preserve"
-        if (XMLElement *t = r->FirstChildElement("w:t"))
+        };
+        at(Tag::Ilvl) = [](XMLElement *e, PropertySet &s)
         {
-            const char *space = t->Attribute("xml:space");
-            if (space && std::strcmp(space, "preserve") == 0)
+            if (e->Attribute("w:val"))
             {
-                // preserve spaces
+                s.level = std::atoi(e->Attribute("w:val"));
+                s.has |= PropertySet::HasLevel;
             }
-            else
-            {
-                // Trim leading and trailing spaces
-                size_t first = run.text.find_first_not_of(' ');
-                size_t last = run.text.find_last_not_of(' ');
-                if (first == std::string::npos || last == std::string::npos)
-                {
-                    run.text = "";
-                }
-                else
-                {
-                    run.text = run.text.substr(first, (last - first + 1));
-                }
+        };
+        at(Tag::NumStyle) = [](XMLElement *e, PropertySet &s)
+        {
+            readString(e->Attribute("w:val"), PropertySet::HasNumberStyle, s, s.numberStyle);
+        };
+        return t;
+    }();
+    return table.data();
+}
+
+// Decodes the recognized children of a property element into a set
+// @param parent: w:rPr, w:pPr or w:numPr element
+// @param set: receives the properties
+// @return the w:rStyle / w:pStyle child, null if absent
+static XMLElement *decodeProperties(XMLElement *parent, PropertySet &set)
+{
+    static const PropertyDecoder *decoders = propertyDecoders();
+    XMLElement *styleRef = nullptr;
+    for (XMLElement *e = parent->FirstChildElement(); e; e = e->NextSiblingElement())
+    {
+        Tag tag = tagOf(e->Name());
+        if (PropertyDecoder decode = decoders[static_cast<size_t>(tag)])
+            decode(e, set);
+        else if ((tag == Tag::RStyle || tag == Tag::PStyle) && !styleRef)
+            styleRef = e;
+    }
+    return styleRef;
+}
+
+// Converts a style declaration to the public Style structure
+// @param decl: style declaration
+// @return Style with the properties set by the style itself
+static Style toStyle(const StyleDecl &decl)
+{
+    const PropertySet &set = decl.properties;
+    Style st;
+    st.styleType = decl.type;
+    st.basedOn = decl.basedOn;
+    st.bold = set.flag(PropertySet::HasBold);
+    st.italic = set.flag(PropertySet::HasItalic);
+    st.underline = set.flag(PropertySet::HasUnderline);
+    st.strikeThrough = set.flag(PropertySet::HasStrike);
+    st.Subscript = set.flag(PropertySet::HasSubscript);
+    st.Superscript = set.flag(PropertySet::HasSuperscript);
+    st.color = set.color;
+    st.backColor = set.backColor;
+    st.fontFamily = set.fontFamily;
+    st.fontSize = set.fontSize;
+    st.level = set.level;
+    st.numbered = set.flag(PropertySet::HasNumbered);
+    st.numberFormat = set.numberFormat;
+    st.numberStyle = set.numberStyle;
+    st.lineSpacing = set.lineSpacing;
+    st.spaceBefore = set.spaceBefore;
+    st.spaceAfter = set.spaceAfter;
+    st.spaceBetweenSameStyle = set.flag(PropertySet::HasExactSpacing);
+    st.justification = set.justification;
+    st.rightDirection = set.flag(PropertySet::HasRightDirection);
+    st.indentLeft = set.indentLeft;
+    st.indentRight = set.indentRight;
+    st.indentFirstLine = set.indentFirstLine;
+    st.tabs = set.tabs;
+    return st;
+}
+
+
+// ---------------- Styles parsing ----------------
+// Parses styles.xml and returns a map of styleId -> style declaration
+// @param xml: styles.xml content, parsed in place (the buffer is modified)
+// @return map of styleId -> StyleDecl
+static StyleDecls parseStyles(std::string &xml)
+{
+    StyleDecls map;
+    if (xml.empty())
+        return map;
+
+    XMLDocument doc;
+    parseXmlInPlace(doc, xml);
+    XMLElement *root = doc.FirstChildElement("w:styles");
+    if (!root)
+        return map;
+
+    // Parse each style
+    for (XMLElement *s = root->FirstChildElement("w:style"); s;
+         s = s->NextSiblingElement("w:style"))
+    {
+        const char *id = s->Attribute("w:styleId");
+        if (!id)
+            continue;
+
+        StyleDecl st;
+        if (const char *t = s->Attribute("w:type"))
+            st.type =
+                (std::strcmp(t, "paragraph") == 0) ? ElementType::Paragraph : ElementType::Run;
+
+        // Based on
+        if (XMLElement *b = s->FirstChildElement("w:basedOn"))
+            if (b->Attribute("w:val"))
+                st.basedOn = b->Attribute("w:val");
+
+        // Run and paragraph properties
+        if (XMLElement *rPr = s->FirstChildElement("w:rPr"))
+            decodeProperties(rPr, st.properties);
+        if (XMLElement *pPr = s->FirstChildElement("w:pPr"))
+            decodeProperties(pPr, st.properties);
+
+        // add the new style to the map
+        map.emplace(id, std::move(st));
+    }
+
+    return map;
+}
+
+
+// ------------ Content walkers -------------
+// Content can be wrapped in containers that add no structure of their own:
+// content controls (w:sdt / w:sdtContent) and custom XML at block and
+// inline level, and hyperlinks, smart tags, insertions and simple fields
+// around runs. Text boxes (w:txbxContent) hold block content inside the
+// drawings of a run. The walkers below look through all of them, and
+// through tables, in document order with an explicit stack instead of
+// recursion, so a deeply nested document cannot exhaust the call stack.
+// Nesting is bounded only by the depth limit of the XML parser.
+
+// Stack of the walkers
+// The first frames live inside the stack object, so walking ordinary
+// content allocates nothing; deeper frames spill to the heap.
+template <class T>
+class ContentStack {
+public:
+    bool empty() const { return size_ == 0; }
+
+    void push(const T &frame)
+    {
+        if (size_ < inlineFrames)
+            inline_[size_] = frame;
+        else
+            spill_.push_back(frame);
+        ++size_;
+    }
+
+    T pop()
+    {
+        --size_;
+        if (size_ < inlineFrames)
+            return inline_[size_];
+        T frame = spill_.back();
+        spill_.pop_back();
+        return frame;
+    }
+
+private:
+    static const size_t inlineFrames = 16;
+    T              inline_[inlineFrames];
+    std::vector<T> spill_;      // frames past inlineFrames
+    size_t         size_ = 0;
+};
+
+// @return true if the element is a block-level container without structure
+static bool isBlockWrapper(std::string_view name)
+{
+    return name == "w:sdt" || name == "w:sdtContent" || name == "w:customXml";
+}
+
+// @return true if the element is an inline container holding runs
+static bool isInlineWrapper(const char *name)
+{
+    return std::strcmp(name, "w:hyperlink") == 0 ||
+           std::strcmp(name, "w:sdt") == 0 ||
+           std::strcmp(name, "w:sdtContent") == 0 ||
+           std::strcmp(name, "w:customXml") == 0 ||
+           std::strcmp(name, "w:smartTag") == 0 ||
+           std::strcmp(name, "w:ins") == 0 ||
+           std::strcmp(name, "w:fldSimple") == 0;
+}
+
+// @return true if the run child may hold a text box
+static bool isDrawing(const char *name)
+{
+    return std::strcmp(name, "w:drawing") == 0 ||
+           std::strcmp(name, "w:pict") == 0 ||
+           std::strcmp(name, "mc:AlternateContent") == 0;
+}
+
+// Events reported by walkBlocks
+enum class BlockEvent {
+    Paragraph,              // a w:p
+    TableStart, TableEnd,   // a w:tbl
+    RowStart, RowEnd,       // a w:tr of the open table
+    CellStart, CellEnd,     // a w:tc of the open row
+    CellProperties          // the w:tcPr of the open cell
+};
+
+// Walks block content: an element and its following siblings, with
+// everything they contain
+// Paragraphs are reported where content may hold them (body, cells, notes,
+// text boxes), rows only inside tables and cells only inside rows, so start
+// and end events always pair up and nest. The properties of a cell follow
+// its start event. The paragraphs of a text box
+// follow the paragraph anchoring it; mc:Fallback, a copy of the preceding
+// mc:Choice, is skipped.
+// @param first: first element to walk
+// @param onBlock: called with each event and its element; return false to stop
+// @return false if the walk was stopped
+template <class OnBlock>
+static bool walkBlocks(XMLElement *first, OnBlock &&onBlock)
+{
+    // What the children of an element are
+    enum class Scope {
+        Content,    // paragraphs and tables
+        Table,      // rows
+        Row,        // cells
+        Inline,     // runs, in a paragraph or an inline container
+        Run,        // run content, searched for drawings
+        Drawing     // drawing markup, searched for text boxes
+    };
+    struct Frame {
+        XMLElement *element;    // open container
+        Scope       scope;      // scope of the container itself
+        bool        structural; // a table, row or cell, reported on close
+        BlockEvent  end;        // event closing a structural container
+    };
+    ContentStack<Frame> stack;
+    Scope scope = Scope::Content;
+
+    for (XMLElement *e = first; e;)
+    {
+        const char *name = e->Name();
+        Scope inner = scope;
+        BlockEvent start = BlockEvent::Paragraph, end = BlockEvent::Paragraph;
+        bool enter = false, structural = false;
+        switch (scope)
+        {
+        case Scope::Content:
+            if (std::strcmp(name, "w:p") == 0)
+            {
+                if (!onBlock(BlockEvent::Paragraph, e))
+                    return false;
+                enter = true;               // for its text boxes
+                inner = Scope::Inline;
+            }
+            else if (std::strcmp(name, "w:tcPr") == 0)
+            {
+                if (!onBlock(BlockEvent::CellProperties, e))
+                    return false;
+            }
+            else if (std::strcmp(name, "w:tbl") == 0)
+            {
+                enter = structural = true;
+                start = BlockEvent::TableStart, end = BlockEvent::TableEnd, inner = Scope::Table;
+            }
+            else
+                enter = isBlockWrapper(name);
+            break;
+        case Scope::Table:
+            if (std::strcmp(name, "w:tr") == 0)
+            {
+                enter = structural = true;
+                start = BlockEvent::RowStart, end = BlockEvent::RowEnd, inner = Scope::Row;
+            }
+            else
+                enter = isBlockWrapper(name);
+            break;
+        case Scope::Row:
+            if (std::strcmp(name, "w:tc") == 0)
+            {
+                enter = structural = true;
+                start = BlockEvent::CellStart, end = BlockEvent::CellEnd, inner = Scope::Content;
+            }
+            else
+                enter = isBlockWrapper(name);
+            break;
+        case Scope::Inline:
+            if (std::strcmp(name, "w:r") == 0)
+                enter = true, inner = Scope::Run;
+            else
+                enter = isInlineWrapper(name);
+            break;
+        case Scope::Run:
+            if (isDrawing(name))
+                enter = true, inner = Scope::Drawing;
+            break;
+        case Scope::Drawing:
+            if (std::strcmp(name, "w:txbxContent") == 0)
+                enter = true, inner = Scope::Content;
+            else
+                enter = std::strcmp(name, "mc:Fallback") != 0;
+            break;
+        }
+
+        if (enter)
+        {
+            if (structural && !onBlock(start, e))
+                return false;
+            stack.push(Frame{ e, scope, structural, end });
+            scope = inner;
+            if (XMLElement *child = e->FirstChildElement())
+            {
+                e = child;
+                continue;
+            }
+        }
+        else
+        {
+            e = e->NextSiblingElement();
+            if (e || stack.empty())
+                continue;
+        }
+
+        // Close the finished containers, then move to the next sibling
+        for (e = nullptr; !e && !stack.empty();)
+        {
+            const Frame frame = stack.pop();
+            scope = frame.scope;
+            if (frame.structural && !onBlock(frame.end, frame.element))
+                return false;
+            e = frame.element->NextSiblingElement();
+        }
+    }
+    return true;
+}
+
+// Walks the runs of a paragraph in document order, looking through inline
+// containers
+// @param p: paragraph element
+// @param onRun: called with each w:r
+template <class OnRun>
+static void walkRuns(XMLElement *p, OnRun &&onRun)
+{
+    ContentStack<XMLElement *> stack;       // open inline containers
+    for (XMLElement *e = p->FirstChildElement(); e || !stack.empty();)
+    {
+        if (!e)
+        {
+            e = stack.pop()->NextSiblingElement();
+            continue;
+        }
+        const char *name = e->Name();
+        if (std::strcmp(name, "w:r") == 0)
+            onRun(e);
+        else if (isInlineWrapper(name))
+        {
+            if (XMLElement *child = e->FirstChildElement())
+            {
+                stack.push(e);
+                e = child;
+                continue;
+            }
+        }
+        e = e->NextSiblingElement();
+    }
+}
+
+
+// ------------ Parse Footnotes -------------
+// Parses footnotes.xml and returns a map of footnote ID -> text
+// @param xml: footnotes.xml content, parsed in place (the buffer is modified)
+// @param ctx: style resolution context
+// @param alloc: allocator of the note paragraphs
+// @return map of footnote ID -> text
+// @todo: handle complex footnotes with multiple paragraphs, etc.
+// For now, we just collect plain text
+// @todo: support footnotes with styles
+template <template <class> class Alloc>
+static std::unordered_map<int, BasicNote<Alloc>> parseFootnotes(std::string &xml,
+                                                                StyleContext &ctx,
+                                                                const Alloc<char> &alloc)
+{
+    std::unordered_map<int, BasicNote<Alloc>> map;
+    if (xml.empty())
+        return map;
+
+    XMLDocument doc;
+    parseXmlInPlace(doc, xml);
+
+    XMLElement *root = doc.FirstChildElement("w:footnotes");
+    if (!root)
+        return map;
+
+    // Parse each footnote
+    for (XMLElement *fn = root->FirstChildElement("w:footnote"); fn;
+         fn = fn->NextSiblingElement("w:footnote"))
+    {
+        const char *idAttr = fn->Attribute("w:id");
+        if (!idAttr)
+            continue;
+        int id = std::atoi(idAttr);
+
+        // Skip separator footnotes
+        const char *typeAttr = fn->Attribute("w:type");
+        if (typeAttr &&
+            (std::strcmp(typeAttr, "separator") == 0 ||
+             std::strcmp(typeAttr, "continuationSeparator") == 0))
+        {
+            continue; // skip separators
+        }
+
+        // For now, get the styled text
+        BasicVector<BasicParagraph<Alloc>, Alloc> paragraphs(alloc);
+        // Collect paragraphs
+        walkBlocks(fn->FirstChildElement(), [&](BlockEvent event, XMLElement *p)
+        {
+            if (event == BlockEvent::Paragraph)
+                paragraphs.emplace_back(readParagraph(p, ctx, alloc));
+            return true;
+        });
+        
+        // Add to map
+        map[id] = BasicNote<Alloc>{id, std::move(paragraphs)};
+    }
+
+    return map;
+}
+
+
+// ------------ Parse Endnotes -------------
+// Parses endnotes.xml and returns a map of endnote ID -> text
+// @param xml: endnotes.xml content, parsed in place (the buffer is modified)
+// @param ctx: style resolution context
+// @param alloc: allocator of the note paragraphs
+// @return map of endnote ID -> text
+template <template <class> class Alloc>
+static std::unordered_map<int, BasicNote<Alloc>> parseEndnotes(std::string &xml,
+                                                               StyleContext &ctx,
+                                                               const Alloc<char> &alloc)
+{
+    std::unordered_map<int, BasicNote<Alloc>> map;
+    if (xml.empty())
+        return map;
+
+    XMLDocument doc;
+    parseXmlInPlace(doc, xml);
+
+    XMLElement *root = doc.FirstChildElement("w:endnotes");
+    if (!root)
+        return map;
+
+    // Parse each endnote
+    for (XMLElement *en = root->FirstChildElement("w:endnote"); en;
+         en = en->NextSiblingElement("w:endnote"))
+    {
+        const char *idAttr = en->Attribute("w:id");
+        if (!idAttr)
+            continue;
+        int id = std::atoi(idAttr);
+
+        // Skip separator endnotes
+        const char *typeAttr = en->Attribute("w:type");
+        if (typeAttr &&
+            (std::strcmp(typeAttr, "separator") == 0 ||
+             std::strcmp(typeAttr, "continuationSeparator") == 0))
+        {
+            continue; // skip separators
+        }
+
+        // For now, get the styled text
+        BasicVector<BasicParagraph<Alloc>, Alloc> paragraphs(alloc);
+        // Collect paragraphs
+        walkBlocks(en->FirstChildElement(), [&](BlockEvent event, XMLElement *p)
+        {
+            if (event == BlockEvent::Paragraph)
+                paragraphs.emplace_back(readParagraph(p, ctx, alloc));
+            return true;
+        });
+        
+        // Add to map
+        map[id] = BasicNote<Alloc>{id, std::move(paragraphs)};
+    }
+
+    return map;
+}
+
+
+// ------------ Append Run -------------
+// Appends a run to a paragraph, merging it into the previous run when both
+// have the same style, so runs that would be coalesced are never created.
+// Formats are interned, so equal formats have equal IDs. Footnote
+// references always stay runs of their own.
+// @param runs: runs of the paragraph
+// @param text: text of the run
+// @param format: ID of the run format
+// @param noteId: footnote ID, 0 if the run is not a footnote reference
+template <template <class> class Alloc>
+static void appendRun(BasicVector<BasicRun<Alloc>, Alloc> &runs,
+                      std::string_view text,
+                      uint32_t format,
+                      uint32_t noteId)
+{
+    if (noteId == 0 && !runs.empty() &&
+        runs.back().noteId == 0 && runs.back().format == format)
+    {
+        runs.back().text.append(text.data(), text.size());
+        return;
+    }
+
+    runs.push_back(BasicRun<Alloc>{
+        BasicString<Alloc>(text.data(), text.size(), runs.get_allocator()), format, noteId });
+}
+
+
+// ------------ Read Paragraph Style -------------
+// Reads the style ID of a paragraph
+// @param p: XML element representing the paragraph
+// @return style ID, empty if the paragraph has no style
+static std::string readParagraphStyleId(XMLElement *p)
+{
+    if (XMLElement *pPr = p->FirstChildElement("w:pPr"))
+        if (XMLElement *pStyle = pPr->FirstChildElement("w:pStyle"))
+            if (const char *val = pStyle->Attribute("w:val"))
+                return val;
+    return std::string();
+}
+
+
+// ------------ Read Run Text -------------
+// Reads the text of a run, trimmed unless xml:space="preserve"
+// @param r: XML element representing the run
+// @return view of the text inside the parsed XML buffer
+static std::string_view readRunText(XMLElement *r)
+{
+    XMLElement *t = r->FirstChildElement("w:t");
+    if (!t || !t->GetText())
+        return std::string_view();
+
+    std::string_view text(t->GetText());
+    const char *space = t->Attribute("xml:space");
+    if (space && std::strcmp(space, "preserve") == 0)
+        return text; // preserve spaces
+
+    // Trim leading and trailing spaces
+    size_t first = text.find_first_not_of(' ');
+    if (first == std::string_view::npos)
+        return std::string_view();
+    size_t last = text.find_last_not_of(' ');
+    return text.substr(first, last - first + 1);
+}
+
+
+// ------------ Read Run Format -------------
+// Resolves the format of a run: its run style (or the paragraph style),
+// overridden by the direct properties
+// @param rPr: run properties element, may be null
+// @param pStyle: index of the paragraph style in the style table
+// @param ctx: style resolution context
+// @return ID of the interned format
+static uint32_t readRunFormat(XMLElement *rPr,
+                              uint32_t pStyle,
+                              StyleContext &ctx)
+{
+    if (!rPr || !ctx.resolveFormatting)
+        return 0;
+
+    PropertySet direct;
+    uint32_t styleIndex = pStyle; // inherit from paragraph style
+    // Run style
+    if (XMLElement *rStyle = decodeProperties(rPr, direct))
+    {
+        const char *val = rStyle->Attribute("w:val");
+        if (val && *val)
+            styleIndex = ctx.styles.find(val);
+    }
+
+    // Start with the run style, then override with direct properties
+    RunFormat fmt = ctx.styles.runFormats[styleIndex];
+    applyRunProperties(fmt, direct);
+
+    return ctx.formats.intern(fmt);
+}
+
+
+// ------------ Read Paragraph -------------
+// Reads a paragraph from an XML element
+// @param p: XML element representing the paragraph
+// @param ctx: style resolution context
+// @param alloc: allocator of the paragraph content
+// @return Paragraph object
+template <template <class> class Alloc>
+static BasicParagraph<Alloc> readParagraph(XMLElement *p,
+                                           StyleContext &ctx,
+                                           const Alloc<char> &alloc)
+{
+    BasicParagraph<Alloc> para;
+    para.tabs = BasicVector<Tab, Alloc>(alloc);
+    para.runs = BasicVector<BasicRun<Alloc>, Alloc>(alloc);
+    std::string pStyleId = readParagraphStyleId(p);
+    uint32_t pStyle = !ctx.resolveFormatting ? 0
+                    : pStyleId.empty() ? ctx.styles.normal : ctx.styles.find(pStyleId);
+
+    if (XMLElement *pPr = p->FirstChildElement("w:pPr"))
+    {
+        para.style = pStyleId;
+        // Paragraph style, then direct properties
+        if (ctx.resolveFormatting)
+        {
+            PropertySet direct;
+            decodeProperties(pPr, direct);
+            applyParagraphProperties(para, ctx.styles.resolved[pStyle]);
+            applyParagraphProperties(para, direct);
+        }
+    }
+
+    // Now, parse runs, those in hyperlinks and other containers included
+    // Each run may override the paragraph style
+    walkRuns(p, [&](XMLElement *r)
+    {
+        // Footnote reference always creates a new run
+        if (XMLElement *fr = r->FirstChildElement("w:footnoteReference"))
+        {
+            if (fr->Attribute("w:id"))
+            {
+                int id = std::atoi(fr->Attribute("w:id"));
+                appendRun(para.runs, fr->GetText() ? fr->GetText() : "", 0, id);
+                return;
+            }
+        }
+
+        // Adjacent runs with the same style are merged as they are read
+        appendRun(para.runs, readRunText(r),
+                  readRunFormat(r->FirstChildElement("w:rPr"), pStyle, ctx), 0);
+    });
+    return para;
+}
+
+
+// ------------ Read Paragraph View -------------
+// Reads a paragraph from an XML element without copying its text
+// @param p: XML element representing the paragraph
+// @param ctx: style resolution context
+// @return ParagraphView whose run texts point into the parsed XML buffer
+static ParagraphView readParagraphView(XMLElement *p,
+                                       StyleContext &ctx)
+{
+    ParagraphView para;
+    para.style = readParagraphStyleId(p);
+    uint32_t pStyle = !ctx.resolveFormatting ? 0
+                    : para.style.empty() ? ctx.styles.normal : ctx.styles.find(para.style);
+
+    walkRuns(p, [&](XMLElement *r)
+    {
+        RunView run;
+        // Footnote reference always creates a new run
+        if (XMLElement *fr = r->FirstChildElement("w:footnoteReference"))
+        {
+            if (fr->Attribute("w:id"))
+            {
+                run.noteId = std::atoi(fr->Attribute("w:id"));
+                if (fr->GetText())
+                    run.text = fr->GetText();
+                para.runs.push_back(run);
+                return;
+            }
+        }
+
+        run.text = readRunText(r);
+        run.format = readRunFormat(r->FirstChildElement("w:rPr"), pStyle, ctx);
+        para.runs.push_back(run);
+    });
+    return para;
+}
+
+
+// ------------ Body builder -------------
+// Builds paragraphs and tables from block events, of walkBlocks or of the
+// body scanner (see streamBodyBlocks)
+// Paragraphs, those of table cells included, are appended in document
+// order. A table takes its slot in tables when it starts, so tables nested
+// in its cells follow it; the open tables are kept on an explicit stack.
+// Only paragraphs and cell properties need their element; a table is built
+// from its events alone, and never needs a DOM of its own.
+template <template <class> class Alloc>
+struct BodyBuilder {
+    StyleContext &ctx;                  // style resolution context
+    const Alloc<char> &alloc;           // allocator of the paragraphs and tables
+    BasicVector<BasicParagraph<Alloc>, Alloc> &paras;   // receives the paragraphs
+    BasicVector<BasicTable<Alloc>, Alloc> &tables;      // receives the tables
+
+    // A table being read
+    struct OpenTable {
+        size_t    slot;                 // index of the table in tables
+        BasicTable<Alloc> table;
+        TableRow  row;                  // row being read
+        TableCell cell;                 // cell being read
+    };
+    std::vector<OpenTable> open;        // tables being read, innermost last
+
+    BodyBuilder(StyleContext &c, const Alloc<char> &a,
+                BasicVector<BasicParagraph<Alloc>, Alloc> &p,
+                BasicVector<BasicTable<Alloc>, Alloc> &t)
+        : ctx(c), alloc(a), paras(p), tables(t) {}
+
+    bool operator()(BlockEvent event, XMLElement *e)
+    {
+        const uint32_t paraCount = static_cast<uint32_t>(paras.size());
+        switch (event)
+        {
+        case BlockEvent::Paragraph:
+            paras.emplace_back(readParagraph(e, ctx, alloc));
+            break;
+        case BlockEvent::TableStart:
+        {
+            OpenTable t{ tables.size(), BasicTable<Alloc>(), TableRow(), TableCell() };
+            t.table.level = static_cast<uint32_t>(open.size());
+            t.table.firstParagraph = paraCount;
+            t.table.rows = BasicVector<TableRow, Alloc>(alloc);
+            t.table.cells = BasicVector<TableCell, Alloc>(alloc);
+            tables.emplace_back();
+            open.push_back(std::move(t));
+            break;
+        }
+        case BlockEvent::TableEnd:
+        {
+            OpenTable &t = open.back();
+            t.table.paragraphCount = paraCount - t.table.firstParagraph;
+            tables[t.slot] = std::move(t.table);
+            open.pop_back();
+            break;
+        }
+        case BlockEvent::RowStart:
+            open.back().row = TableRow();
+            open.back().row.firstCell = static_cast<uint32_t>(open.back().table.cells.size());
+            break;
+        case BlockEvent::RowEnd:
+        {
+            OpenTable &t = open.back();
+            t.row.cellCount = static_cast<uint32_t>(t.table.cells.size()) - t.row.firstCell;
+            t.table.rows.push_back(t.row);
+            break;
+        }
+        case BlockEvent::CellStart:
+            open.back().cell = TableCell();
+            open.back().cell.firstParagraph = paraCount;
+            break;
+        case BlockEvent::CellProperties:
+        {
+            if (open.empty())
+                break;
+            TableCell &cell = open.back().cell;
+            if (XMLElement *span = e->FirstChildElement("w:gridSpan"))
+                parseNumber(span->Attribute("w:val"), cell.gridSpan);
+            if (XMLElement *vMerge = e->FirstChildElement("w:vMerge"))
+            {
+                const char *val = vMerge->Attribute("w:val");
+                cell.mergedAbove = !val || std::strcmp(val, "restart") != 0;
+            }
+            break;
+        }
+        case BlockEvent::CellEnd:
+        {
+            OpenTable &t = open.back();
+            t.cell.paragraphCount = paraCount - t.cell.firstParagraph;
+            t.table.cells.push_back(t.cell);
+            break;
+        }
+        }
+        return true;
+    }
+};
+
+
+// -------- Body scanner --------
+// Event-driven scanner over document.xml
+// Tokenizes just enough XML (tags, comments, CDATA, processing instructions)
+// to track element nesting, and reports the body as the events of
+// walkBlocks: it descends into tables, rows and cells, reporting where each
+// starts and ends, and through content controls and custom XML. Paragraphs
+// and cell properties are reported as complete byte ranges; other elements
+// (section and table properties, bookmarks, ...) are skipped. Nothing is
+// allocated; the caller parses one paragraph at a time, so memory is
+// bounded by the largest paragraph instead of the whole body, however its
+// content is nested.
+// The scanner can be resumed: when a token is cut at the end of the
+// available data it reports NeedMore and rescans that token on the next call.
+class BodyScanner {
+public:
+    enum class Event {
+        Block,      // a block event is available
+        NeedMore,   // the available data ends inside a token
+        End         // w:body was closed
+    };
+
+    // Scans forward to the next block event
+    // @param buf: document text
+    // @param len: number of bytes available in buf
+    // @param block: receives the block event on Event::Block
+    // @param begin: receives the offset of the element of a Paragraph or
+    //               CellProperties event
+    // @param end: receives the offset just past that element
+    // @return the scan event
+    Event next(const char *buf, size_t len, BlockEvent &block, size_t &begin, size_t &end)
+    {
+        if (done_)
+            return Event::End;
+        if (pending_)
+        {
+            // End of a self-closing table, row or cell
+            pending_ = false;
+            block = pendingEvent_;
+            return Event::Block;
+        }
+
+        while (pos_ < len)
+        {
+            // Skip character data up to the next markup
+            if (buf[pos_] != '<')
+            {
+                const void *lt = std::memchr(buf + pos_, '<', len - pos_);
+                if (!lt)
+                {
+                    pos_ = len;
+                    break;
+                }
+                pos_ = static_cast<size_t>(static_cast<const char *>(lt) - buf);
+            }
+
+            const size_t tagStart = pos_;
+            int m;
+            // Comments, CDATA sections and processing instructions
+            if ((m = matchPrefix(buf, len, "<!--")) != 0)
+            {
+                if (m < 0 || !skipPast(buf, len, "-->"))
+                    return Event::NeedMore;
+                continue;
+            }
+            if ((m = matchPrefix(buf, len, "<![CDATA[")) != 0)
+            {
+                if (m < 0 || !skipPast(buf, len, "]]>"))
+                    return Event::NeedMore;
+                continue;
+            }
+            if ((m = matchPrefix(buf, len, "<?")) != 0)
+            {
+                if (m < 0 || !skipPast(buf, len, "?>"))
+                    return Event::NeedMore;
+                continue;
+            }
+            if ((m = matchPrefix(buf, len, "<!")) != 0)
+            {
+                if (m < 0 || !skipPast(buf, len, ">"))
+                    return Event::NeedMore;
+                continue;
+            }
+
+            // Element tags
+            size_t gt = findTagEnd(buf, len, tagStart + 1);
+            if (gt == len)
+                return Event::NeedMore;
+            pos_ = gt + 1;
+            const bool endTag = buf[tagStart + 1] == '/';
+            const bool selfClosing = !endTag && buf[gt - 1] == '/';
+
+            // Inside a reported or skipped element, only its nesting matters
+            if (skipDepth_ > 0)
+            {
+                if (endTag)
+                    --skipDepth_;
+                else if (!selfClosing)
+                    ++skipDepth_;
+                if (skipDepth_ == 0 && capture_)
+                {
+                    capture_ = false;
+                    block = captured_;
+                    begin = blockStart_;
+                    end = pos_;
+                    return Event::Block;
+                }
+                continue;
+            }
+
+            const std::string_view name = tagName(buf, tagStart + (endTag ? 2 : 1), gt);
+            if (!inBody_)
+            {
+                if (!endTag && name == "w:body")
+                {
+                    if (selfClosing)
+                    {
+                        done_ = true;
+                        return Event::End;
+                    }
+                    inBody_ = true;
+                }
+                continue;
+            }
+
+            if (endTag)
+            {
+                // Closes the innermost container, or w:body if none is open
+                if (open_.empty())
+                {
+                    done_ = true;
+                    return Event::End;
+                }
+                const Frame frame = open_.pop();
+                scope_ = frame.scope;
+                if (frame.structural)
+                {
+                    block = frame.end;
+                    return Event::Block;
+                }
+                continue;
+            }
+
+            // Start tag, interpreted by the scope it appears in
+            Scope inner = scope_;
+            BlockEvent start = BlockEvent::Paragraph, close = BlockEvent::Paragraph;
+            bool enter = false, structural = false;
+            switch (scope_)
+            {
+            case Scope::Content:
+                if (name == "w:p" || name == "w:tcPr")
+                {
+                    block = name == "w:p" ? BlockEvent::Paragraph : BlockEvent::CellProperties;
+                    if (selfClosing)
+                    {
+                        begin = tagStart;
+                        end = pos_;
+                        return Event::Block;
+                    }
+                    captured_ = block;
+                    blockStart_ = tagStart;
+                    skipDepth_ = 1;
+                    capture_ = true;
+                    continue;
+                }
+                if (name == "w:tbl")
+                {
+                    enter = structural = true;
+                    start = BlockEvent::TableStart, close = BlockEvent::TableEnd, inner = Scope::Table;
+                }
+                else
+                    enter = isBlockWrapper(name);
+                break;
+            case Scope::Table:
+                if (name == "w:tr")
+                {
+                    enter = structural = true;
+                    start = BlockEvent::RowStart, close = BlockEvent::RowEnd, inner = Scope::Row;
+                }
+                else
+                    enter = isBlockWrapper(name);
+                break;
+            case Scope::Row:
+                if (name == "w:tc")
+                {
+                    enter = structural = true;
+                    start = BlockEvent::CellStart, close = BlockEvent::CellEnd, inner = Scope::Content;
+                }
+                else
+                    enter = isBlockWrapper(name);
+                break;
+            }
+
+            if (!enter)
+            {
+                if (!selfClosing)
+                    skipDepth_ = 1;     // no paragraphs inside, e.g. w:sectPr, w:tblPr
+                continue;
+            }
+            if (selfClosing)
+            {
+                if (!structural)
+                    continue;
+                pending_ = true;
+                pendingEvent_ = close;
+            }
+            else
+            {
+                open_.push(Frame{ scope_, structural, close });
+                scope_ = inner;
+                if (!structural)
+                    continue;
+            }
+            block = start;
+            return Event::Block;
+        }
+        return Event::NeedMore;
+    }
+
+    // @return offset of the first byte still needed by the scanner
+    size_t keepFrom() const
+    {
+        return capture_ ? blockStart_ : pos_;
+    }
+
+    // Informs the scanner that the first n bytes were dropped from the buffer
+    // @param n: number of dropped bytes, at most keepFrom()
+    void discard(size_t n)
+    {
+        pos_ -= n;
+        blockStart_ = blockStart_ >= n ? blockStart_ - n : 0;
+    }
+
+private:
+    // Matches a markup prefix at the current position
+    // @return 1 on match, 0 on mismatch, -1 if the data ends before deciding
+    int matchPrefix(const char *buf, size_t len, const char *prefix) const
+    {
+        size_t n = std::strlen(prefix);
+        size_t avail = std::min(n, len - pos_);
+        if (std::memcmp(buf + pos_, prefix, avail) != 0)
+            return 0;
+        return avail == n ? 1 : -1;
+    }
+
+    // Moves the position past the next occurrence of a terminator
+    // @return false if the terminator is not in the available data
+    bool skipPast(const char *buf, size_t len, const char *terminator)
+    {
+        const char *last = buf + len;
+        const char *found = std::search(buf + pos_ + 1, last,
+                                        terminator, terminator + std::strlen(terminator));
+        if (found == last)
+            return false;
+        pos_ = static_cast<size_t>(found - buf) + std::strlen(terminator);
+        return true;
+    }
+
+    // Finds the '>' closing a tag, skipping quoted attribute values
+    // @return offset of the '>', or len if the tag is incomplete
+    static size_t findTagEnd(const char *buf, size_t len, size_t from)
+    {
+        char quote = 0;
+        for (size_t i = from; i < len; ++i)
+        {
+            char c = buf[i];
+            if (quote)
+            {
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '>')
+                return i;
+        }
+        return len;
+    }
+
+    // @return the tag name starting at from, in a tag closed at gt
+    static std::string_view tagName(const char *buf, size_t from, size_t gt)
+    {
+        size_t n = from;
+        while (n < gt && buf[n] != ' ' && buf[n] != '\t' && buf[n] != '\r' &&
+               buf[n] != '\n' && buf[n] != '/')
+            ++n;
+        return std::string_view(buf + from, n - from);
+    }
+
+    // What the children of the innermost open container are
+    enum class Scope : uint8_t {
+        Content,    // paragraphs and tables: the body, a cell
+        Table,      // rows
+        Row         // cells
+    };
+    // An open container
+    struct Frame {
+        Scope      scope;       // scope around the container
+        bool       structural;  // a table, row or cell, reported on close
+        BlockEvent end;         // event closing a structural container
+    };
+
+    size_t pos_ = 0;            // scan position
+    size_t blockStart_ = 0;     // start of the element being reported
+    int    skipDepth_ = 0;      // open elements of the element being reported or skipped
+    ContentStack<Frame> open_;  // open tables, rows, cells and content controls
+    Scope  scope_ = Scope::Content;
+    BlockEvent captured_ = BlockEvent::Paragraph;       // event of the element being reported
+    BlockEvent pendingEvent_ = BlockEvent::Paragraph;   // event to report on the next call
+    bool   capture_ = false;    // the element being scanned is reported when closed
+    bool   pending_ = false;    // pendingEvent_ is to be reported
+    bool   inBody_ = false;     // w:body was opened
+    bool   done_ = false;       // w:body was closed
+};
+
+
+// -------- Stream body elements --------
+// Callback receiving the block events of the body, see walkBlocks; the
+// element of a table, row or cell is null unless it is in a text box.
+// Return false to stop.
+using BlockCallback = std::function<bool(BlockEvent, XMLElement *)>;
+
+// Parses one scanned element in place and walks it
+// @param block: XML document reused for all elements
+// @param buf: buffer holding the element, modified by the parser
+// @param begin: offset of the element in buf
+// @param end: offset just past the element in buf
+// @param onBlock: receives the events of the element, see walkBlocks
+// @return false if the callback stopped the walk
+static bool parseBodyBlock(XMLDocument &block,
+                           std::string &buf,
+                           size_t begin,
+                           size_t end,
+                           const BlockCallback &onBlock)
+{
+    // Terminate the element for the in-place parse, restore it afterwards
+    // since the scanner continues from there
+    char saved = buf[end];
+    buf[end] = '\0';
+    block.ParseInPlace(&buf[begin], end - begin);
+    bool more = true;
+    if (XMLElement *e = block.RootElement())
+        more = walkBlocks(e, onBlock);
+    block.Clear();
+    buf[end] = saved;
+    return more;
+}
+
+// Reports a scanned block event
+// Paragraphs and cell properties are parsed and walked, so the paragraphs
+// of their text boxes are reported too; tables, rows and cells are reported
+// without an element.
+// @return false if the callback stopped the walk
+static bool reportBodyBlock(XMLDocument &block,
+                            std::string &buf,
+                            BlockEvent event,
+                            size_t begin,
+                            size_t end,
+                            const BlockCallback &onBlock)
+{
+    if (event == BlockEvent::Paragraph || event == BlockEvent::CellProperties)
+        return parseBodyBlock(block, buf, begin, end, onBlock);
+    return onBlock(event, nullptr);
+}
+
+// Streams the block events of the body of an XML part held in memory
+// @param xml: part content, parsed in place; the paragraph texts are decoded
+//             in place and stay valid in the buffer afterwards
+// @param onBlock: called with each block event; return false to stop
+static void streamBodyBlocks(std::string &xml,
+                             const BlockCallback &onBlock)
+{
+    BodyScanner scanner;
+    XMLDocument block;
+    BlockEvent event;
+    size_t begin = 0, end = 0;
+    while (scanner.next(xml.data(), xml.size(), event, begin, end) == BodyScanner::Event::Block)
+    {
+        if (!reportBodyBlock(block, xml, event, begin, end, onBlock))
+            break;
+    }
+}
+
+// Feeds the body scanner with a part arriving chunk by chunk
+// Keeps a window holding only the data the scanner has not consumed yet;
+// every complete paragraph is parsed in place on its own, with one small
+// DOM reused for all of them.
+class BodyStream {
+public:
+    // @param onBlock: called with each block event; return false to stop
+    explicit BodyStream(BlockCallback onBlock) : onBlock_(std::move(onBlock)) {}
+
+    // Scans the next chunk of the part, reporting the block events it completes
+    // @param chunk: next bytes of the part
+    // @param n: number of bytes in chunk
+    // @return false once the body ended or the callback stopped
+    bool feed(const char *chunk, size_t n)
+    {
+        window_.append(chunk, n);
+        BlockEvent event;
+        size_t begin = 0, end = 0;
+        for (;;)
+        {
+            BodyScanner::Event ev = scanner_.next(window_.data(), window_.size(), event, begin, end);
+            if (ev == BodyScanner::Event::End)
+                return false;   // nothing after the body is needed
+            if (ev == BodyScanner::Event::NeedMore)
+                break;
+            if (!reportBodyBlock(block_, window_, event, begin, end, onBlock_))
+                return false;
+        }
+        // Drop what the scanner has consumed
+        size_t keep = scanner_.keepFrom();
+        if (keep > 0)
+        {
+            window_.erase(0, keep);
+            scanner_.discard(keep);
+        }
+        return true;
+    }
+
+private:
+    BlockCallback onBlock_;
+    BodyScanner scanner_;
+    XMLDocument block_;
+    std::string window_;        // data not yet consumed by the scanner
+};
+
+// Streams the block events of the body of an XML part straight from the
+// archive
+// The part is inflated chunk by chunk into a BodyStream. Neither the
+// inflated part nor a DOM of a table or of the whole body is ever held in
+// memory, and inflating and parsing are pipelined chunk by chunk.
+// @param zip: opened document archive
+// @param name: part name, e.g. word/document.xml
+// @param onBlock: called with each block event; return false to stop
+// @return false if the part is missing
+static bool streamBodyBlocks(ZipArchive &zip,
+                             const std::string &name,
+                             const BlockCallback &onBlock)
+{
+    int fileIndex = zip.find(name);
+    if (fileIndex < 0)
+        return false;
+
+    BodyStream stream(onBlock);
+    zip.stream(fileIndex, [&](const char *chunk, size_t n)
+    {
+        return stream.feed(chunk, n);
+    });
+    return true;
+}
+
+
+// -------- Parse main document.xml --------
+// Parses document.xml and returns a vector of Paragraphs
+// The body is streamed event by event, see streamBodyBlocks, and built by
+// a BodyBuilder.
+// @param zip: opened document archive
+// @param ctx: style resolution context
+// @param alloc: allocator of the paragraphs and tables
+// @param tables: receives the tables of the body
+// @return vector of Paragraphs, the paragraphs of the tables included
+template <template <class> class Alloc>
+static BasicVector<BasicParagraph<Alloc>, Alloc> parseMainDocument(
+    ZipArchive &zip,
+    StyleContext &ctx,
+    const Alloc<char> &alloc,
+    BasicVector<BasicTable<Alloc>, Alloc> &tables)
+{
+    BasicVector<BasicParagraph<Alloc>, Alloc> paras(alloc);
+    tables = BasicVector<BasicTable<Alloc>, Alloc>(alloc);
+
+    // Collect paragraphs and tables
+    BodyBuilder<Alloc> builder(ctx, alloc, paras, tables);
+    streamBodyBlocks(zip, "word/document.xml", std::ref(builder));
+
+    return paras;
+}
+
+
+// -------- Text scanner --------
+// Scanner extracting the plain text of an XML part
+// Copies the content of w:t elements, decoding entities, and ends a line
+// at every closing w:p. w:tab in a run becomes '\t' and w:br / w:cr a
+// space, so words around them stay apart. mc:Fallback content (a copy of
+// the preceding mc:Choice) and separator notes are skipped. No DOM, style
+// or run is built. Like BodyScanner, the scanner can be resumed: it stops
+// before a token cut at the end of the available data.
+// Lines come in the order of walkBlocks: the paragraphs of a text box are
+// held back until the paragraph anchoring it ends, and in the main
+// document only the body is read, up to the end tag closing it.
+class TextScanner {
+public:
+    // @param body: read only the content of w:body, as BodyScanner does
+    explicit TextScanner(bool body = false) : inBody_(!body), body_(body) {}
+
+    // @return true once w:body was closed; the rest of the part is ignored
+    bool done() const { return done_; }
+
+    // Scans the next chunk of a part, appending its text
+    // A token cut at the end of the chunk is carried over to the next one.
+    // @param chunk: next bytes of the part
+    // @param n: number of bytes in chunk
+    // @param out: receives the text
+    void feed(const char *chunk, size_t n, std::string &out)
+    {
+        if (carry_.empty())
+        {
+            size_t used = scan(chunk, n, out);
+            carry_.assign(chunk + used, n - used);
+        }
+        else
+        {
+            carry_.append(chunk, n);
+            carry_.erase(0, scan(carry_.data(), carry_.size(), out));
+        }
+    }
+
+    // Scans the available data, appending its text
+    // @param buf: part text
+    // @param len: number of bytes available in buf
+    // @param out: receives the text
+    // @return number of bytes consumed; the rest starts with a cut token
+    size_t scan(const char *buf, size_t len, std::string &out)
+    {
+        size_t pos = 0;
+        while (pos < len && !done_)
+        {
+            // Character data up to the next markup
+            if (buf[pos] != '<')
+            {
+                const void *lt = std::memchr(buf + pos, '<', len - pos);
+                size_t stop = lt ? static_cast<size_t>(static_cast<const char *>(lt) - buf) : len;
+                if (inText_ && skipDepth_ == 0)
+                {
+                    size_t used = appendText(buf + pos, stop - pos, lt != nullptr, target(out));
+                    if (used < stop - pos)
+                        return pos + used;
+                }
+                pos = stop;
+                continue;
+            }
+
+            if (pos + 1 == len)
+                return pos;
+
+            // Comments, CDATA sections, processing instructions and declarations
+            if (buf[pos + 1] == '!' || buf[pos + 1] == '?')
+            {
+                static const struct { const char *open, *close; } markups[] = {
+                    { "<!--", "-->" }, { "<![CDATA[", "]]>" }, { "<?", "?>" }, { "<!", ">" },
+                };
+                for (const auto &m : markups)
+                {
+                    size_t n = std::strlen(m.open);
+                    size_t avail = std::min(n, len - pos);
+                    if (std::memcmp(buf + pos, m.open, avail) != 0)
+                        continue;
+                    if (avail < n)
+                        return pos;
+                    const char *last = buf + len;
+                    const char *found = std::search(buf + pos + n, last, m.close, m.close + std::strlen(m.close));
+                    if (found == last)
+                        return pos;
+                    if (inText_ && skipDepth_ == 0 && m.open[2] == '[')
+                        target(out).append(buf + pos + n, found);   // CDATA is text as is
+                    pos = static_cast<size_t>(found - buf) + std::strlen(m.close);
+                    break;
+                }
+                continue;
             }
+
+            // Element tags
+            size_t gt = findTagEnd(buf, len, pos + 1);
+            if (gt == len)
+                return pos;
+            if (buf[pos + 1] == '/')
+                endTag(std::string_view(buf + pos + 2, nameLength(buf + pos + 2, buf + gt)), out);
+            else
+                startTag(std::string_view(buf + pos + 1, gt - pos - 1), buf[gt - 1] == '/', out);
+            pos = gt + 1;
+        }
+        return done_ ? len : pos;
+    }
+
+private:
+    // Text of an open paragraph nested in another one's text box
+    struct Nested {
+        std::string text;       // its own line, still open
+        std::string after;      // lines of the paragraphs nested in it
+    };
+
+    // @return where the text of the innermost open paragraph goes
+    std::string &target(std::string &out)
+    {
+        return paraDepth_ <= 1 ? out : nested_[paraDepth_ - 1].text;
+    }
+
+    void openParagraph()
+    {
+        if (++paraDepth_ > nested_.size())
+            nested_.resize(paraDepth_);
+    }
+
+    // Ends the line of the innermost open paragraph, followed by the lines
+    // of its text boxes
+    void closeParagraph(std::string &out)
+    {
+        if (paraDepth_ == 0)
+            return;
+        Nested &closed = nested_[paraDepth_ - 1];
+        if (--paraDepth_ == 0)
+        {
+            out += '\n';
+            out += closed.after;
+        }
+        else
+        {
+            std::string &lines = nested_[paraDepth_ - 1].after;
+            lines += closed.text;
+            lines += '\n';
+            lines += closed.after;
+            closed.text.clear();
+        }
+        closed.after.clear();
+    }
+
+    // @param tag: content of the start tag between '<' and '>'
+    void startTag(std::string_view tag, bool selfClosing, std::string &out)
+    {
+        std::string_view name = tag.substr(0, nameLength(tag.data(), tag.data() + tag.size()));
+        if (!inBody_)
+        {
+            inBody_ = name == "w:body" && !selfClosing;
+            return;
+        }
+        if (body_ && !selfClosing)
+            ++depth_;
+        if (skipDepth_ > 0)
+        {
+            if (!selfClosing)
+                ++skipDepth_;
+        }
+        else if (name == "w:t")
+        {
+            if (selfClosing)
+                return;
+            inText_ = true;
+            textStart_ = target(out).size();
+            size_t space = tag.find("xml:space=");
+            preserve_ = space != std::string_view::npos &&
+                        tag.size() >= space + 19 &&
+                        tag.substr(space + 11, 8) == "preserve";
+        }
+        else if (name == "w:tabs")
+            inTabs_ = !selfClosing;         // tab stops, not tab characters
+        else if (name == "w:tab")
+        {
+            if (!inTabs_)
+                target(out) += '\t';
+        }
+        else if (name == "w:br" || name == "w:cr")
+            target(out) += ' ';
+        else if (name == "w:p")
+        {
+            openParagraph();
+            if (selfClosing)
+                closeParagraph(out);        // empty paragraph
+        }
+        else if (!selfClosing &&
+                 (name == "mc:Fallback" ||
+                  ((name == "w:footnote" || name == "w:endnote") &&
+                   (tag.find("w:type=\"separator\"") != std::string_view::npos ||
+                    tag.find("w:type=\"continuationSeparator\"") != std::string_view::npos))))
+            skipDepth_ = 1;
+    }
+
+    // @param name: name of the end tag
+    void endTag(std::string_view name, std::string &out)
+    {
+        if (!inBody_)
+            return;
+        if (body_ && depth_-- == 0)
+        {
+            done_ = true;                   // closes w:body, whatever its name
+            return;
         }
+        if (skipDepth_ > 0)
+            --skipDepth_;
+        else if (name == "w:t")
+        {
+            inText_ = false;
+            if (!preserve_)
+                trimText(target(out));
+        }
+        else if (name == "w:tabs")
+            inTabs_ = false;
+        else if (name == "w:p")
+            closeParagraph(out);
+    }
 
-        // Run properties
-        if (XMLElement *rPr = r->FirstChildElement("w:rPr"))
+    // Appends character data, decoding entities
+    // @param complete: true if the data is followed by markup, so an
+    //                  entity without ';' is malformed rather than cut
+    // @return number of bytes consumed, less than len if an entity is cut
+    static size_t appendText(const char *text, size_t len, bool complete, std::string &out)
+    {
+        size_t pos = 0;
+        while (pos < len)
         {
-            // Run style
-            if (XMLElement *rStyle = rPr->FirstChildElement("w:rStyle"))
+            const void *amp = std::memchr(text + pos, '&', len - pos);
+            if (!amp)
             {
-                if (rStyle->Attribute("w:val"))
-                    rStyleId = rStyle->Attribute("w:val");
+                out.append(text + pos, len - pos);
+                return len;
             }
-            if (rStyleId.empty()) {
-                rStyleId = pStyleId; // inherit from paragraph style
+            size_t at = static_cast<size_t>(static_cast<const char *>(amp) - text);
+            out.append(text + pos, at - pos);
+            const void *semi = std::memchr(text + at, ';', len - at);
+            if (!semi)
+            {
+                if (!complete)
+                    return at;
+                out.append(text + at, len - at);
+                return len;
             }
-            
-            // Merge styles
-            // Start with the run style, then override with direct properties
-            Style rStyle = mergeStyleCached(styles, rStyleId);
-            if (rStyle.bold)
-                run.bold = true;
-            if (rStyle.italic)
-                run.italic = true;
-            if (rStyle.underline)
-                run.underline = true;
-            if (rStyle.strikeThrough)
-                run.strike = true;
-            if (rStyle.Subscript)
-                run.subscript = true;
-            if (rStyle.Superscript)
-                run.superscript = true;
-            if (!rStyle.color.empty())
-                run.color = rStyle.color;
-            if (!rStyle.backColor.empty())
-                run.backColor = rStyle.backColor;
-            if (!rStyle.fontFamily.empty())
-                run.fontFamily = rStyle.fontFamily;
-            if (rStyle.fontSize > 0)
-                run.fontSize = rStyle.fontSize;
+            size_t end = static_cast<size_t>(static_cast<const char *>(semi) - text);
+            if (!appendEntity(std::string_view(text + at + 1, end - at - 1), out))
+                out.append(text + at, end + 1 - at);
+            pos = end + 1;
+        }
+        return len;
+    }
 
-            // Direct properties
-            // Now, override with direct properties from rPr
-            if (XMLElement *lang = rPr->FirstChildElement("w:lang"))
+    // Appends the character of an entity
+    // @param entity: entity name between '&' and ';'
+    // @return false if the entity is unknown
+    static bool appendEntity(std::string_view entity, std::string &out)
+    {
+        static const struct { const char *name; char c; } named[] = {
+            { "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+        };
+        for (const auto &e : named)
+        {
+            if (entity == e.name)
             {
-                if (lang->Attribute("w:val"))
-                    run.lang = lang->Attribute("w:val");
+                out += e.c;
+                return true;
             }
-            if (rPr->FirstChildElement("w:b"))
-                run.bold = true;
-            if (rPr->FirstChildElement("w:i"))
-                run.italic = true;
-            if (rPr->FirstChildElement("w:u"))
-                run.underline = true;
-            if (rPr->FirstChildElement("w:strike"))
-                run.strike = true;
-            if (rPr->FirstChildElement("w:subscript"))
-                run.subscript = true;
-            if (rPr->FirstChildElement("w:superscript"))
-                run.superscript = true;
-            if (XMLElement *c = rPr->FirstChildElement("w:color"))
+        }
+        if (entity.size() < 2 || entity[0] != '#')
+            return false;
+
+        // Character reference, encoded as UTF-8
+        uint32_t cp = 0;
+        const bool hex = entity[1] == 'x' || entity[1] == 'X';
+        const char *first = entity.data() + (hex ? 2 : 1);
+        const char *last = entity.data() + entity.size();
+        auto res = std::from_chars(first, last, cp, hex ? 16 : 10);
+        if (res.ec != std::errc() || res.ptr != last || cp > 0x10FFFF)
+            return false;
+        if (cp < 0x80)
+            out += static_cast<char>(cp);
+        else if (cp < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        return true;
+    }
+
+    // Trims the spaces around the text of the closed w:t, as readRunText does
+    void trimText(std::string &out) const
+    {
+        while (out.size() > textStart_ && out.back() == ' ')
+            out.pop_back();
+        size_t first = textStart_;
+        while (first < out.size() && out[first] == ' ')
+            ++first;
+        out.erase(textStart_, first - textStart_);
+    }
+
+    // @return length of the tag name starting at name
+    static size_t nameLength(const char *name, const char *end)
+    {
+        const char *p = name;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '/')
+            ++p;
+        return static_cast<size_t>(p - name);
+    }
+
+    // Finds the '>' closing a tag, skipping quoted attribute values
+    // Jumps from quote to quote with memchr instead of testing every byte
+    // @return offset of the '>', or len if the tag is incomplete
+    static size_t findTagEnd(const char *buf, size_t len, size_t from)
+    {
+        for (;;)
+        {
+            const char *gt = static_cast<const char *>(std::memchr(buf + from, '>', len - from));
+            if (!gt)
+                return len;
+            // First quote before the '>'
+            const char *quote = static_cast<const char *>(std::memchr(buf + from, '"', gt - (buf + from)));
+            const char *apos = static_cast<const char *>(
+                std::memchr(buf + from, '\'', (quote ? quote : gt) - (buf + from)));
+            if (apos)
+                quote = apos;
+            if (!quote)
+                return static_cast<size_t>(gt - buf);
+            // Skip the quoted value
+            const char *close = static_cast<const char *>(
+                std::memchr(quote + 1, *quote, buf + len - (quote + 1)));
+            if (!close)
+                return len;
+            from = static_cast<size_t>(close - buf) + 1;
+        }
+    }
+
+    std::string carry_;         // cut token of the previous chunk
+    std::vector<Nested> nested_;    // open paragraphs, outermost first; the text
+                                    // of the outermost goes straight to the output
+    size_t textStart_ = 0;      // offset in the target of the open w:t text
+    size_t paraDepth_ = 0;      // open paragraphs
+    size_t depth_ = 0;          // open elements in w:body
+    int    skipDepth_ = 0;      // open elements of a skipped subtree, 0 if none
+    bool   inText_ = false;     // inside a w:t
+    bool   preserve_ = false;   // the open w:t preserves its spaces
+    bool   inTabs_ = false;     // inside w:tabs (tab stops)
+    bool   inBody_;             // inside w:body, or reading the whole part
+    bool   done_ = false;       // w:body was closed
+    const bool body_;           // only w:body is read
+};
+
+// Extracts the plain text of a part straight from the archive
+// The part is inflated chunk by chunk; only a token cut at the end of a
+// chunk is carried over to the next one.
+// @param zip: opened document archive
+// @param name: part name, e.g. word/document.xml
+// @param body: read only the body of the part, the main document
+// @param out: receives the text, one line per paragraph
+static void extractPartText(ZipArchive &zip, const char *name, bool body, std::string &out)
+{
+    int fileIndex = zip.find(name);
+    if (fileIndex < 0)
+        return;
+
+    TextScanner scanner(body);
+    zip.stream(fileIndex, [&](const char *chunk, size_t n)
+    {
+        scanner.feed(chunk, n, out);
+        return !scanner.done();
+    });
+}
+
+
+// ------------ Work-stealing pool -------------
+// Per-worker queue of job indices
+// The owner pops from the back, thieves steal from the front
+struct WorkQueue {
+    std::mutex         mutex;
+    std::deque<size_t> jobs;
+};
+
+// Runs count jobs on a work-stealing pool and waits for all of them
+// Jobs are dealt round-robin to the workers; a worker whose queue runs dry
+// steals from the others until every queue is empty.
+// @param count: number of jobs
+// @param threads: number of worker threads (0 = hardware concurrency)
+// @param job: function executing the job with the given index
+// @throws the first exception thrown by a job, after all workers finished
+static void runWorkStealing(size_t count,
+                            unsigned threads,
+                            const std::function<void(size_t)> &job)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads > count)
+        threads = static_cast<unsigned>(count);
+
+    // Small batches run on the calling thread
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    std::vector<WorkQueue> queues(threads);
+    for (size_t i = 0; i < count; ++i)
+        queues[i % threads].jobs.push_back(i);
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    auto worker = [&](unsigned self)
+    {
+        for (;;)
+        {
+            size_t index = 0;
+            bool found = false;
+
+            // Own queue first
             {
-                if (c->Attribute("w:val"))
-                    run.color = Color(c->Attribute("w:val"));
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                if (!queues[self].jobs.empty())
+                {
+                    index = queues[self].jobs.back();
+                    queues[self].jobs.pop_back();
+                    found = true;
+                }
             }
-            if (XMLElement *shd = rPr->FirstChildElement("w:shd"))
+            // Then steal from the others
+            for (unsigned k = 1; !found && k < threads; ++k)
             {
-                if (shd->Attribute("w:fill"))
-                    run.backColor = Color(shd->Attribute("w:fill"));
+                WorkQueue &victim = queues[(self + k) % threads];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.jobs.empty())
+                {
+                    index = victim.jobs.front();
+                    victim.jobs.pop_front();
+                    found = true;
+                }
             }
-            if (XMLElement *rf = rPr->FirstChildElement("w:rFonts"))
+            // No job is ever added, so empty queues mean we are done
+            if (!found)
+                return;
+
+            try
             {
-                if (rf->Attribute("w:ascii"))
-                    run.fontFamily = rf->Attribute("w:ascii");
+                job(index);
             }
-            if (XMLElement *sz = rPr->FirstChildElement("w:sz"))
+            catch (...)
             {
-                if (sz->Attribute("w:val"))
-                    run.fontSize = std::stof(sz->Attribute("w:val")) / 2.0f;
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
             }
         }
-        para.runs.emplace_back(std::move(run));
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (auto &th : pool)
+        th.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+// ------------ Document arena -------------
+// Memory of an ArenaDocument, one monotonic arena per part
+// Each arena starts with a block sized from its part, so a document is
+// typically parsed with a handful of allocations and freed in one go.
+struct DocumentArena {
+    std::pmr::monotonic_buffer_resource body;
+    std::pmr::monotonic_buffer_resource footnotes;
+    std::pmr::monotonic_buffer_resource endnotes;
+
+    explicit DocumentArena(ZipArchive &zip)
+        : body(initialSize(zip, "word/document.xml")),
+          footnotes(initialSize(zip, "word/footnotes.xml")),
+          endnotes(initialSize(zip, "word/endnotes.xml"))
+    {
     }
-    mergeAdjacentRuns(para.runs);
-    return para;
+
+private:
+    // Parsed content is roughly half the size of its XML
+    static size_t initialSize(ZipArchive &zip, const char *part)
+    {
+        return std::max<size_t>(zip.size(zip.find(part)) / 2, 4096);
+    }
+};
+
+
+// ------------ Arena document copy and move -------------
+// Copies are heap-backed: the containers' allocators select the heap on copy
+ArenaDocument::ArenaDocument(const ArenaDocument &other)
+    : BasicDocument<ArenaAllocator>(other)
+{
 }
 
+// The content is released while its arena is still alive
+ArenaDocument::~ArenaDocument()
+{
+    BasicDocument<ArenaAllocator>::operator=(BasicDocument<ArenaAllocator>());
+}
 
-// -------- Parse main document.xml --------
-// Parses document.xml and returns a vector of Paragraphs
-// @param xml: document.xml content
-// @param styles: map of styleId -> Style
-// @return vector of Paragraphs
-static std::vector<Paragraph> parseMainDocument(
-    const std::string &xml,
-    const StyleMap &styles)
-{
-    std::vector<Paragraph> paras;
-    if (xml.empty())
-        return paras;
+// The old content is released before the arena it may live in
+ArenaDocument &ArenaDocument::operator=(ArenaDocument &&other) noexcept
+{
+    if (this != &other)
+    {
+        BasicDocument<ArenaAllocator>::operator=(std::move(other));
+        arena = std::move(other.arena);
+    }
+    return *this;
+}
 
-    XMLDocument doc;
-    doc.Parse(xml.c_str());
+ArenaDocument &ArenaDocument::operator=(const ArenaDocument &other)
+{
+    if (this != &other)
+        *this = ArenaDocument(other);
+    return *this;
+}
 
-    XMLElement *root = doc.FirstChildElement("w:document");
-    if (!root)
-        return paras;
-    XMLElement *body = root->FirstChildElement("w:body");
-    if (!body)
-        return paras;
 
-    // Collect paragraphs
-    for (XMLElement *p = body->FirstChildElement("w:p"); p;
-         p = p->NextSiblingElement("w:p"))
+// ------------ Load styles -------------
+// Inflates and parses styles.xml, unless the shared cache already holds it
+// Uncached styles are not shared, so the caller may move the map out.
+// @param zip: opened document archive
+// @param cache: shared style cache, may be null
+// @return parsed styles, empty if the part is missing
+static std::shared_ptr<ParsedStyles> loadStyles(ZipArchive &zip, StyleCache *cache)
+{
+    int index = zip.find("word/styles.xml");
+    StyleCache::Key key = 0;
+    uint32_t crc32 = 0;
+    size_t size = 0;
+    bool cacheable = cache && zip.stat(index, crc32, size);
+    if (cacheable)
     {
-        Paragraph para = readParagraph(p, styles);
-        paras.emplace_back(std::move(para));
+        key = (StyleCache::Key(crc32) << 32) | static_cast<uint32_t>(size);
+        if (auto hit = cache->find(key))
+            return std::const_pointer_cast<ParsedStyles>(hit);
     }
 
-    return paras;
+    StyleDecls decls;
+    {
+        // Only a part that inflated and matched its CRC is cached, so a
+        // damaged copy never stands in for the styles of its template
+        std::string data;
+        cacheable = zip.extract(index, data) && cacheable;
+        decls = parseStyles(data);
+    }
+    auto styles = std::make_shared<ParsedStyles>();
+    styles->map.reserve(decls.size());
+    for (const auto &decl : decls)
+        styles->map.emplace(decl.first, toStyle(decl.second));
+    styles->table = std::make_shared<const StyleTable>(buildStyleTable(decls));
+    if (cacheable)
+        cache->insert(key, styles);
+    return styles;
 }
 
+// @param zip: opened document archive
+// @param options: read options
+// @return resolved styles of the document, empty if options skip them
+static std::shared_ptr<const StyleTable> loadStyleTable(ZipArchive &zip,
+                                                        const ReadOptions &options)
+{
+    if (!options.readStyles)
+        return emptyStyleTable();
+    return loadStyles(zip, options.styleCache.get())->table;
+}
 
+// Loads the styles of a document into Document::styles, unless skipped
+// @param map: receives the styles of the document
+// @param zip: opened document archive
+// @param options: read options
+// @return resolved styles of the document
+static std::shared_ptr<const StyleTable> takeStyles(StyleMap &map,
+                                                    ZipArchive &zip,
+                                                    const ReadOptions &options)
+{
+    if (!options.readStyles)
+        return emptyStyleTable();
+    std::shared_ptr<ParsedStyles> styles = loadStyles(zip, options.styleCache.get());
+    if (options.styleCache)
+        map = styles->map;
+    else
+        map = std::move(styles->map);
+    return styles->table;
+}
 
-// ---------------- Public API Functions ----------------
-// Read document from file path
-MINIDOCKLIB_API Document readDocument(
-    const std::string &path)
+
+// ------------ Read document parts -------------
+// Reads and parses all parts of a document
+// Styles are parsed first; footnotes, endnotes and the main document only
+// read the styles, so with intraDocumentParallelism each of them is
+// decompressed and parsed on its own thread.
+// Each part has an allocator of its own, so the parts can be parsed on
+// separate threads into separate arenas.
+// @param zip: opened document archive
+// @param options: read options
+// @param doc: receives the document
+// @param bodyAlloc: allocator of the body
+// @param footnoteAlloc: allocator of the footnotes
+// @param endnoteAlloc: allocator of the endnotes
+template <template <class> class Alloc>
+static void readDocumentParts(ZipArchive &zip,
+                              const ReadOptions &options,
+                              BasicDocument<Alloc> &doc,
+                              const Alloc<char> &bodyAlloc,
+                              const Alloc<char> &footnoteAlloc,
+                              const Alloc<char> &endnoteAlloc)
+{
+    if (!options.intraDocumentParallelism)
+    {
+        // Each part is inflated right before it is parsed and released
+        // right after, so only one decompressed part is alive at a time
+        std::string data;
+
+        // Parse styles
+        StyleContext ctx(takeStyles(doc.styles, zip, options), options.resolveFormatting);
+        // Parse footnotes
+        if (options.readFootnotes)
+        {
+            zip.extract("word/footnotes.xml", data);
+            doc.footnotes = parseFootnotes(data, ctx, footnoteAlloc);
+        }
+        // Parse endnotes
+        if (options.readEndnotes)
+        {
+            zip.extract("word/endnotes.xml", data);
+            doc.endnotes = parseEndnotes(data, ctx, endnoteAlloc);
+        }
+        // Parse main document
+        doc.paragraphs = parseMainDocument(zip, ctx, bodyAlloc, doc.tables);
+        doc.runFormats = std::move(ctx.formats.formats);
+        return;
+    }
+
+    // Parse styles, all other parts depend on them
+    StyleContext ctx(takeStyles(doc.styles, zip, options), options.resolveFormatting);
+    ctx.formats.shared = options.readFootnotes || options.readEndnotes;
+
+    // Footnotes and endnotes on their own threads, main document on this one
+    std::future<std::unordered_map<int, BasicNote<Alloc>>> footnotes, endnotes;
+    if (options.readFootnotes)
+    {
+        footnotes = std::async(std::launch::async, [&]
+        {
+            std::string data;
+            zip.extract("word/footnotes.xml", data);
+            return parseFootnotes(data, ctx, footnoteAlloc);
+        });
+    }
+    if (options.readEndnotes)
+    {
+        endnotes = std::async(std::launch::async, [&]
+        {
+            std::string data;
+            zip.extract("word/endnotes.xml", data);
+            return parseEndnotes(data, ctx, endnoteAlloc);
+        });
+    }
+    doc.paragraphs = parseMainDocument(zip, ctx, bodyAlloc, doc.tables);
+    if (footnotes.valid())
+        doc.footnotes = footnotes.get();
+    if (endnotes.valid())
+        doc.endnotes = endnotes.get();
+    doc.runFormats = std::move(ctx.formats.formats);
+}
+
+// Reads and parses all parts of a document into the heap
+// @param zip: opened document archive
+// @param options: read options
+// @return Document structure representing the document
+static Document readDocumentParts(ZipArchive &zip, const ReadOptions &options)
 {
     Document doc;
+    const std::allocator<char> heap;
+    readDocumentParts(zip, options, doc, heap, heap, heap);
+    return doc;
+}
+
+// Reads and parses all parts of a document into an arena per part
+// @param zip: opened document archive
+// @param options: read options
+// @return ArenaDocument structure representing the document
+static ArenaDocument readArenaDocumentParts(ZipArchive &zip, const ReadOptions &options)
+{
+    ArenaDocument doc;
+    doc.arena = std::make_shared<DocumentArena>(zip);
+    readDocumentParts(zip, options, doc,
+                      ArenaAllocator<char>(&doc.arena->body),
+                      ArenaAllocator<char>(&doc.arena->footnotes),
+                      ArenaAllocator<char>(&doc.arena->endnotes));
+    return doc;
+}
 
-    g_mergedStyleCache.clear();
 
-    std::vector<std::string> filesToRead = {
-        "word/document.xml",
-        "word/styles.xml",
-        "word/footnotes.xml",
-        "word/endnotes.xml"
-    };
+// ------------ Stream document paragraphs -------------
+// Parses the styles, then streams the body paragraphs of a document
+// @param zip: opened document archive
+// @param onParagraph: callback receiving each paragraph
+// @param options: read options
+// @return false if the archive has no main document
+static bool streamDocumentParagraphs(ZipArchive &zip,
+                                     const ParagraphCallback &onParagraph,
+                                     const ReadOptions &options)
+{
+    StyleContext ctx(loadStyleTable(zip, options), options.resolveFormatting);
+
+    return streamBodyBlocks(zip, "word/document.xml", [&](BlockEvent event, XMLElement *p)
+    {
+        if (event != BlockEvent::Paragraph)
+            return true;
+        return onParagraph(readParagraph(p, ctx, std::allocator<char>()),
+                           ctx.formats.formats);
+    });
+}
 
-    // Read necessary files from the ZIP
-    auto fileData = readMultipleFilesFromZIP(path, filesToRead);
-    if (fileData.empty())
-        return doc;
 
-    // Parse styles
-    doc.styles = parseStyles(fileData["word/styles.xml"]);
-    // Parse footnotes
-    doc.footnotes = parseFootnotes(fileData["word/footnotes.xml"], doc.styles);
-    // Parse endnotes
-    doc.endnotes = parseEndnotes(fileData["word/endnotes.xml"], doc.styles);
-    // Parse main document
-    doc.paragraphs = parseMainDocument(fileData["word/document.xml"], doc.styles);
+// ------------ Read document view -------------
+// Reads the body of a document as a zero-copy view
+// document.xml is inflated once and kept by the view; run texts point into it.
+// @param zip: opened document archive
+// @param options: read options
+// @return DocumentView of the body
+static DocumentView readDocumentViewParts(ZipArchive &zip, const ReadOptions &options)
+{
+    DocumentView view;
+    StyleContext ctx(loadStyleTable(zip, options), options.resolveFormatting);
 
-    return doc;
+    auto buffer = std::make_shared<std::string>();
+    if (!zip.extract("word/document.xml", *buffer))
+        return view;
+    streamBodyBlocks(*buffer, [&](BlockEvent event, XMLElement *p)
+    {
+        if (event == BlockEvent::Paragraph)
+            view.paragraphs.emplace_back(readParagraphView(p, ctx));
+        return true;
+    });
+    view.runFormats = std::move(ctx.formats.formats);
+    view.buffer = std::move(buffer);
+    return view;
+}
+
+
+// ------------ Extract document text -------------
+// Extracts the plain text of the body, then of the notes
+// @param zip: opened document archive
+// @param options: read options (readFootnotes and readEndnotes apply)
+// @return text, one line per paragraph
+static std::string extractDocumentText(ZipArchive &zip, const ReadOptions &options)
+{
+    std::string text;
+    extractPartText(zip, "word/document.xml", true, text);
+    if (options.readFootnotes)
+        extractPartText(zip, "word/footnotes.xml", false, text);
+    if (options.readEndnotes)
+        extractPartText(zip, "word/endnotes.xml", false, text);
+    return text;
+}
+
+
+// ------------ Open document archive -------------
+// Opens the archive of a document file
+// @param zip: archive to open
+// @param mapped: receives the file mapping with options.memoryMap, must
+//                outlive the archive
+// @param path: path to the MiniDock (.docx) file
+// @param options: read options
+// @return true on success
+static bool openDocumentFile(ZipArchive &zip,
+                             MappedFile &mapped,
+                             const std::string &path,
+                             const ReadOptions &options)
+{
+    if (options.memoryMap && mapped.open(path))
+        return zip.openMemory(mapped.data(), mapped.size());
+    return zip.openFile(path);
+}
+
+
+// ------------ Lazy document state -------------
+// Everything a lazy document keeps alive: the archive (and its mapping), the
+// style context shared by all parts, and each part once it is parsed.
+// The body is parsed when the document is opened; the other parts on first
+// access, each exactly once.
+struct LazyDocumentState {
+    MappedFile mapped;                          // file mapping, outlives the archive
+    ZipArchive zip;                             // opened document archive
+    ReadOptions options;                        // options of the document
+    std::shared_ptr<ParsedStyles> parsedStyles; // styles.xml, once loaded
+    std::unique_ptr<StyleContext> ctx;          // shared by all parts
+
+    std::vector<Paragraph> paragraphs;          // body, parsed on open
+    std::vector<Table> tables;                  // tables of the body, parsed on open
+    StyleMap styles;                            // parsed on first access
+    std::unordered_map<int, Note> footnotes;    // parsed on first access
+    std::unordered_map<int, Note> endnotes;     // parsed on first access
+    std::once_flag stylesOnce, footnotesOnce, endnotesOnce;
+
+    // Run formats handed out by LazyDocument::format
+    // A deque, so formats interned by a part parsed later never move the
+    // formats already handed out
+    std::deque<RunFormat> formats;
+    std::mutex formatsMutex;                    // guards formats
+
+    // Parses the body, loading styles.xml first if formatting needs it
+    void open()
+    {
+        std::shared_ptr<const StyleTable> table = emptyStyleTable();
+        if (options.readStyles && options.resolveFormatting)
+        {
+            parsedStyles = loadStyles(zip, options.styleCache.get());
+            table = parsedStyles->table;
+        }
+        ctx = std::make_unique<StyleContext>(table, options.resolveFormatting);
+        ctx->formats.shared = true;     // notes may be parsed on any thread
+        paragraphs = parseMainDocument(zip, *ctx, std::allocator<char>(), tables);
+        syncFormats();
+    }
+
+    // Publishes the formats interned since the last call
+    void syncFormats()
+    {
+        std::lock_guard<std::mutex> lock(formatsMutex);
+        std::lock_guard<std::mutex> tableLock(ctx->formats.mutex);
+        const std::vector<RunFormat> &interned = ctx->formats.formats;
+        formats.insert(formats.end(), interned.begin() + formats.size(), interned.end());
+    }
+
+    // Parses a notes part
+    // @param name: name of the part in the archive
+    // @param parse: parseFootnotes or parseEndnotes
+    // @param out: receives the notes
+    void loadNotes(const char *name,
+                   std::unordered_map<int, Note> (*parse)(std::string &, StyleContext &,
+                                                          const std::allocator<char> &),
+                   std::unordered_map<int, Note> &out)
+    {
+        std::string data;
+        zip.extract(name, data);
+        out = parse(data, *ctx, std::allocator<char>());
+        syncFormats();
+    }
+};
+
+// Lazy document accessors
+bool LazyDocument::isOpen() const
+{
+    return state != nullptr;
+}
+
+const std::vector<Paragraph> &LazyDocument::paragraphs() const
+{
+    static const std::vector<Paragraph> none;
+    return state ? state->paragraphs : none;
+}
+
+const std::vector<Table> &LazyDocument::tables() const
+{
+    static const std::vector<Table> none;
+    return state ? state->tables : none;
+}
+
+const std::unordered_map<std::string, Style> &LazyDocument::styles() const
+{
+    static const std::unordered_map<std::string, Style> none;
+    if (!state)
+        return none;
+    LazyDocumentState &s = *state;
+    std::call_once(s.stylesOnce, [&s]
+    {
+        if (!s.options.readStyles)
+            return;
+        if (!s.parsedStyles)
+            s.parsedStyles = loadStyles(s.zip, s.options.styleCache.get());
+        s.styles = s.parsedStyles->map;
+    });
+    return s.styles;
+}
+
+const std::unordered_map<int, Note> &LazyDocument::footnotes() const
+{
+    static const std::unordered_map<int, Note> none;
+    if (!state)
+        return none;
+    LazyDocumentState &s = *state;
+    std::call_once(s.footnotesOnce, [&s]
+    {
+        s.loadNotes("word/footnotes.xml", parseFootnotes<std::allocator>, s.footnotes);
+    });
+    return s.footnotes;
+}
+
+const std::unordered_map<int, Note> &LazyDocument::endnotes() const
+{
+    static const std::unordered_map<int, Note> none;
+    if (!state)
+        return none;
+    LazyDocumentState &s = *state;
+    std::call_once(s.endnotesOnce, [&s]
+    {
+        s.loadNotes("word/endnotes.xml", parseEndnotes<std::allocator>, s.endnotes);
+    });
+    return s.endnotes;
+}
+
+const RunFormat &LazyDocument::format(const Run &run) const
+{
+    static const RunFormat none;
+    if (!state)
+        return none;
+    std::lock_guard<std::mutex> lock(state->formatsMutex);
+    return state->formats[run.format];
+}
+
+
+// ---------------- Public API Functions ----------------
+// Read document from file path
+MINIDOCKLIB_API Document readDocument(
+    const std::string &path,
+    const ReadOptions &options)
+{
+    MappedFile mapped;
+    ZipArchive zip;
+    if (!openDocumentFile(zip, mapped, path, options))
+        return Document();
+    return readDocumentParts(zip, options);
 }
 
 // Read document from memory buffer
 MINIDOCKLIB_API Document readDocumentFromMemory(
     const char *data,
-    size_t size)
+    size_t size,
+    const ReadOptions &options)
 {
-    Document doc;
+    ZipArchive zip;
+    if (!zip.openMemory(data, size))
+        return Document();
+    return readDocumentParts(zip, options);
+}
+
+// Read arena-backed document from file path
+MINIDOCKLIB_API ArenaDocument readArenaDocument(
+    const std::string &path,
+    const ReadOptions &options)
+{
+    MappedFile mapped;
+    ZipArchive zip;
+    if (!openDocumentFile(zip, mapped, path, options))
+        return ArenaDocument();
+    return readArenaDocumentParts(zip, options);
+}
 
-    g_mergedStyleCache.clear();
+// Read arena-backed document from memory buffer
+MINIDOCKLIB_API ArenaDocument readArenaDocumentFromMemory(
+    const char *data,
+    size_t size,
+    const ReadOptions &options)
+{
+    ZipArchive zip;
+    if (!zip.openMemory(data, size))
+        return ArenaDocument();
+    return readArenaDocumentParts(zip, options);
+}
 
-    std::vector<std::string> filesToRead = {
-        "word/document.xml",
-        "word/styles.xml",
-        "word/footnotes.xml",
-        "word/endnotes.xml"
-    };
+// Read a batch of documents from file paths
+MINIDOCKLIB_API void readDocuments(
+    const std::vector<std::string> &paths,
+    unsigned threads,
+    const DocumentCallback &onDocument,
+    const ReadOptions &options)
+{
+    runWorkStealing(paths.size(), threads, [&](size_t i)
+    {
+        onDocument(i, readDocument(paths[i], options));
+    });
+}
 
-    auto fileData = readMultipleFilesFromZIPMemory(data, size, filesToRead);
+// Read a batch of documents from memory buffers
+MINIDOCKLIB_API void readDocumentsFromMemory(
+    const std::vector<MemoryBuffer> &buffers,
+    unsigned threads,
+    const DocumentCallback &onDocument,
+    const ReadOptions &options)
+{
+    runWorkStealing(buffers.size(), threads, [&](size_t i)
+    {
+        onDocument(i, readDocumentFromMemory(buffers[i].data, buffers[i].size, options));
+    });
+}
 
-    // Parse styles
-    doc.styles = parseStyles(fileData["word/styles.xml"]);
-    // Parse footnotes
-    doc.footnotes = parseFootnotes(fileData["word/footnotes.xml"], doc.styles);
-    // Parse endnotes
-    doc.endnotes = parseEndnotes(fileData["word/endnotes.xml"], doc.styles);
-    // Parse main document
-    doc.paragraphs = parseMainDocument(fileData["word/document.xml"], doc.styles);
+// Stream paragraphs from file path
+MINIDOCKLIB_API bool forEachParagraph(
+    const std::string &path,
+    const ParagraphCallback &onParagraph,
+    const ReadOptions &options)
+{
+    MappedFile mapped;
+    ZipArchive zip;
+    if (!openDocumentFile(zip, mapped, path, options))
+        return false;
+    return streamDocumentParagraphs(zip, onParagraph, options);
+}
 
-    return doc;
+// Stream paragraphs from memory buffer
+MINIDOCKLIB_API bool forEachParagraphFromMemory(
+    const char *data,
+    size_t size,
+    const ParagraphCallback &onParagraph,
+    const ReadOptions &options)
+{
+    ZipArchive zip;
+    if (!zip.openMemory(data, size))
+        return false;
+    return streamDocumentParagraphs(zip, onParagraph, options);
+}
+
+// Read document view from file path
+MINIDOCKLIB_API DocumentView readDocumentView(
+    const std::string &path,
+    const ReadOptions &options)
+{
+    MappedFile mapped;
+    ZipArchive zip;
+    if (!openDocumentFile(zip, mapped, path, options))
+        return DocumentView();
+    return readDocumentViewParts(zip, options);
+}
+
+// Read document view from memory buffer
+MINIDOCKLIB_API DocumentView readDocumentViewFromMemory(
+    const char *data,
+    size_t size,
+    const ReadOptions &options)
+{
+    ZipArchive zip;
+    if (!zip.openMemory(data, size))
+        return DocumentView();
+    return readDocumentViewParts(zip, options);
+}
+
+// Create a shared style cache
+MINIDOCKLIB_API std::shared_ptr<StyleCache> createStyleCache(size_t capacity)
+{
+    return std::make_shared<StyleCache>(capacity);
+}
+
+// Open a lazy document from file path
+MINIDOCKLIB_API LazyDocument openDocument(
+    const std::string &path,
+    const ReadOptions &options)
+{
+    auto state = std::make_shared<LazyDocumentState>();
+    state->options = options;
+    if (!openDocumentFile(state->zip, state->mapped, path, options))
+        return LazyDocument();
+    state->open();
+    return LazyDocument{ std::move(state) };
+}
+
+// Open a lazy document from memory buffer
+MINIDOCKLIB_API LazyDocument openDocumentFromMemory(
+    const char *data,
+    size_t size,
+    const ReadOptions &options)
+{
+    auto state = std::make_shared<LazyDocumentState>();
+    state->options = options;
+    if (!state->zip.openMemory(data, size))
+        return LazyDocument();
+    state->open();
+    return LazyDocument{ std::move(state) };
+}
+
+// Extract the plain text of a document from file path
+MINIDOCKLIB_API std::string extractText(
+    const std::string &path,
+    const ReadOptions &options)
+{
+    MappedFile mapped;
+    ZipArchive zip;
+    if (!openDocumentFile(zip, mapped, path, options))
+        return std::string();
+    return extractDocumentText(zip, options);
+}
+
+// Extract the plain text of a document from memory buffer
+MINIDOCKLIB_API std::string extractTextFromMemory(
+    const char *data,
+    size_t size,
+    const ReadOptions &options)
+{
+    ZipArchive zip;
+    if (!zip.openMemory(data, size))
+        return std::string();
+    return extractDocumentText(zip, options);
 }
@@ -0,0 +1,427 @@
+// Benchmark of miniDockReader
+// Generates a synthetic DOCX of controlled shape with the vendored miniz
+// writer, then measures the public read functions and each internal stage
+// separately: time per iteration, throughput in MB/s of the input part,
+// paragraphs per second and the peak resident set size during each one.
+//
+// The library source is compiled into this file, so the internal stages
+// (which are static functions) can be timed on their own:
+//   g++ -std=c++17 -O2 -pthread test/benchmark.cpp thirdparty/tinyxml2-master/tinyxml2.cpp -o benchmark
+//
+// Usage: benchmark [--paragraphs=N] [--runs=N] [--style-depth=N]
+//                  [--footnotes=N] [--media=N] [--media-size=BYTES]
+//                  [--min-time=SECONDS] [--filter=TEXT]
+
+#include "../src/miniDockReader.cpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+  #include <malloc.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Shape of the generated document
+struct CorpusShape {
+    size_t paragraphs = 20000;      // body paragraphs
+    size_t runsPerParagraph = 4;    // runs per paragraph
+    size_t styleDepth = 4;          // length of the basedOn chain of the paragraph styles
+    size_t footnotes = 200;         // footnotes, referenced from the body
+    size_t media = 4;               // media entries (stored, not parsed)
+    size_t mediaSize = 256 * 1024;  // size of each media entry in bytes
+};
+
+// Benchmark definition
+struct Benchmark {
+    std::string name;               // reported name
+    size_t bytes;                   // size of the input processed per iteration
+    std::function<size_t()> run;    // runs one iteration, returns the paragraphs read
+};
+
+// Resets the peak resident set size to the current one
+// Linux only (/proc/self/clear_refs); elsewhere the peak of the process can
+// not be reset, and each row reports the peak of the whole run so far.
+// @return true if peakRss() now measures from this point
+bool resetPeakRss() {
+#ifdef __GLIBC__
+    malloc_trim(0);     // return the memory freed by earlier benchmarks first
+#endif
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return static_cast<bool>(clearRefs);
+#else
+    return false;
+#endif
+}
+
+// Returns the peak resident set size of the process in bytes, since the
+// last successful resetPeakRss()
+size_t peakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+  #ifdef __linux__
+    // VmHWM follows resetPeakRss, unlike ru_maxrss
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return static_cast<size_t>(std::stoull(line.substr(6))) * 1024;  // kilobytes
+    }
+  #endif
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+  #ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);         // bytes
+  #else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;  // kilobytes
+  #endif
+#endif
+}
+
+// ---------------- Corpus generator ----------------
+
+std::string generateStyles(const CorpusShape& shape) {
+    std::ostringstream xml;
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        << "<w:styles xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">";
+    xml << "<w:style w:type=\"paragraph\" w:styleId=\"Normal\">"
+        << "<w:pPr><w:spacing w:after=\"200\" w:line=\"276\" w:lineRule=\"auto\"/></w:pPr>"
+        << "<w:rPr><w:rFonts w:ascii=\"Calibri\"/><w:sz w:val=\"22\"/><w:lang w:val=\"en-US\"/></w:rPr>"
+        << "</w:style>";
+    // basedOn chain: Level1 <- Level2 <- ... <- LevelN
+    for (size_t i = 1; i <= shape.styleDepth; ++i) {
+        xml << "<w:style w:type=\"paragraph\" w:styleId=\"Level" << i << "\">"
+            << "<w:basedOn w:val=\"" << (i == 1 ? std::string("Normal") : "Level" + std::to_string(i - 1)) << "\"/>"
+            << "<w:pPr><w:ind w:left=\"" << 360 * i << "\"/>"
+            << "<w:tabs><w:tab w:val=\"left\" w:pos=\"" << 720 * i << "\"/></w:tabs></w:pPr>"
+            << "<w:rPr>" << (i % 2 ? "<w:b/>" : "<w:i/>") << "<w:color w:val=\"1F3864\"/></w:rPr>"
+            << "</w:style>";
+    }
+    xml << "<w:style w:type=\"character\" w:styleId=\"Emphasis\"><w:rPr><w:i/></w:rPr></w:style>";
+    xml << "<w:style w:type=\"character\" w:styleId=\"FootnoteReference\"><w:rPr><w:superscript/></w:rPr></w:style>";
+    xml << "</w:styles>";
+    return xml.str();
+}
+
+std::string generateRun(size_t index, std::mt19937& rng) {
+    static const char* words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur",
+                                   "adipiscing", "elit", "sed", "do", "eiusmod", "tempor",
+                                   "incididunt", "ut", "labore", "&amp;", "magna", "aliqua" };
+    std::string text;
+    size_t count = 3 + rng() % 8;
+    for (size_t i = 0; i < count; ++i) {
+        text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        text += ' ';
+    }
+
+    std::string run = "<w:r>";
+    switch (index % 4) {
+        case 0: break; // inherits the paragraph style
+        case 1: run += "<w:rPr><w:b/><w:sz w:val=\"24\"/></w:rPr>"; break;
+        case 2: run += "<w:rPr><w:rStyle w:val=\"Emphasis\"/></w:rPr>"; break;
+        case 3: run += "<w:rPr><w:color w:val=\"C00000\"/><w:shd w:fill=\"FFFF00\"/></w:rPr>"; break;
+    }
+    run += "<w:t xml:space=\"preserve\">" + text + "</w:t></w:r>";
+    return run;
+}
+
+std::string generateDocument(const CorpusShape& shape, std::mt19937& rng) {
+    std::string xml =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"><w:body>";
+    size_t footnoteEvery = shape.footnotes ? std::max<size_t>(1, shape.paragraphs / shape.footnotes) : 0;
+    size_t footnote = 0;
+    for (size_t p = 0; p < shape.paragraphs; ++p) {
+        xml += "<w:p>";
+        if (shape.styleDepth) {
+            xml += "<w:pPr><w:pStyle w:val=\"Level" + std::to_string(1 + p % shape.styleDepth) + "\"/>";
+            if (p % 5 == 0)
+                xml += "<w:jc w:val=\"both\"/><w:spacing w:before=\"120\"/>";
+            xml += "</w:pPr>";
+        }
+        for (size_t r = 0; r < shape.runsPerParagraph; ++r)
+            xml += generateRun(r, rng);
+        if (footnoteEvery && p % footnoteEvery == 0 && footnote < shape.footnotes) {
+            xml += "<w:r><w:rPr><w:rStyle w:val=\"FootnoteReference\"/></w:rPr><w:footnoteReference w:id=\""
+                 + std::to_string(1 + footnote++) + "\"/></w:r>";
+        }
+        xml += "</w:p>";
+    }
+    xml += "<w:sectPr/></w:body></w:document>";
+    return xml;
+}
+
+std::string generateNotes(const char* root, const char* element, size_t count, std::mt19937& rng) {
+    std::string xml = std::string("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n<") + root
+        + " xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">";
+    xml += std::string("<") + element + " w:type=\"separator\" w:id=\"-1\"><w:p><w:r><w:separator/></w:r></w:p></" + element + ">";
+    for (size_t i = 1; i <= count; ++i) {
+        xml += std::string("<") + element + " w:id=\"" + std::to_string(i) + "\"><w:p>";
+        xml += generateRun(i, rng);
+        xml += std::string("</w:p></") + element + ">";
+    }
+    xml += std::string("</") + root + ">";
+    return xml;
+}
+
+// Writes the generated document with the vendored miniz writer
+bool generateDocx(const CorpusShape& shape, std::vector<char>& docx, size_t& documentXmlSize) {
+    std::mt19937 rng(12345);
+    struct Part { std::string name; std::string data; mz_uint level; };
+    std::vector<Part> parts;
+    parts.push_back({ "[Content_Types].xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?><Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+        "<Default Extension=\"xml\" ContentType=\"application/xml\"/></Types>", MZ_DEFAULT_LEVEL });
+    parts.push_back({ "word/document.xml", generateDocument(shape, rng), MZ_DEFAULT_LEVEL });
+    parts.push_back({ "word/styles.xml", generateStyles(shape), MZ_DEFAULT_LEVEL });
+    parts.push_back({ "word/footnotes.xml", generateNotes("w:footnotes", "w:footnote", shape.footnotes, rng), MZ_DEFAULT_LEVEL });
+    parts.push_back({ "word/endnotes.xml", generateNotes("w:endnotes", "w:endnote", 0, rng), MZ_DEFAULT_LEVEL });
+    for (size_t i = 0; i < shape.media; ++i) {
+        std::string blob(shape.mediaSize, '\0');
+        for (char& c : blob)
+            c = static_cast<char>(rng());
+        // Images are already compressed, Word stores them as is
+        parts.push_back({ "word/media/image" + std::to_string(i + 1) + ".png", std::move(blob), MZ_NO_COMPRESSION });
+    }
+    documentXmlSize = parts[1].data.size();
+
+    mz_zip_archive zip;
+    std::memset(&zip, 0, sizeof(zip));
+    if (!mz_zip_writer_init_heap(&zip, 0, 0))
+        return false;
+    bool ok = true;
+    for (const Part& part : parts)
+        ok = ok && mz_zip_writer_add_mem(&zip, part.name.c_str(), part.data.data(), part.data.size(), part.level);
+    void* buffer = nullptr;
+    size_t size = 0;
+    ok = ok && mz_zip_writer_finalize_heap_archive(&zip, &buffer, &size);
+    if (ok)
+        docx.assign(static_cast<char*>(buffer), static_cast<char*>(buffer) + size);
+    mz_zip_writer_end(&zip);
+    return ok;
+}
+
+// ---------------- Runner ----------------
+
+// Runs a benchmark until minTime has elapsed, and prints one result line
+void runBenchmark(const Benchmark& bench, double minTime) {
+    using Clock = std::chrono::steady_clock;
+    resetPeakRss();
+    bench.run(); // warm-up
+
+    size_t iterations = 0, paragraphs = 0;
+    double elapsed = 0.0;
+    Clock::time_point start = Clock::now();
+    do {
+        paragraphs += bench.run();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minTime);
+
+    double perIteration = elapsed / iterations;
+    double mbPerSecond = bench.bytes / perIteration / (1024.0 * 1024.0);
+    double parasPerSecond = paragraphs / elapsed;
+    std::cout << std::left << std::setw(36) << bench.name << std::right
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << perIteration * 1000.0 << " ms"
+              << std::setw(8) << iterations
+              << std::setprecision(1)
+              << std::setw(11) << mbPerSecond << " MB/s"
+              << std::setprecision(0)
+              << std::setw(13) << parasPerSecond << " para/s"
+              << std::setw(9) << peakRss() / (1024 * 1024) << " MB"
+              << std::endl;
+}
+
+bool readOption(const std::string& arg, const char* name, size_t& value) {
+    std::string prefix = std::string("--") + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    value = static_cast<size_t>(std::stoull(arg.substr(prefix.size())));
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    CorpusShape shape;
+    double minTime = 1.0;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (readOption(arg, "paragraphs", shape.paragraphs) || readOption(arg, "runs", shape.runsPerParagraph) ||
+            readOption(arg, "style-depth", shape.styleDepth) || readOption(arg, "footnotes", shape.footnotes) ||
+            readOption(arg, "media", shape.media) || readOption(arg, "media-size", shape.mediaSize))
+            continue;
+        if (arg.compare(0, 11, "--min-time=") == 0)
+            minTime = std::stod(arg.substr(11));
+        else if (arg.compare(0, 9, "--filter=") == 0)
+            filter = arg.substr(9);
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Generate the corpus
+    std::vector<char> docx;
+    size_t documentXmlSize = 0;
+    if (!generateDocx(shape, docx, documentXmlSize)) {
+        std::cerr << "Failed to generate the document" << std::endl;
+        return 1;
+    }
+    fs::path path = fs::temp_directory_path() / "miniDockReader_benchmark.docx";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(docx.data(), static_cast<std::streamsize>(docx.size()));
+    }
+
+    // Inflated parts, the input of the stages after decompression
+    ZipArchive zip;
+    if (!zip.openMemory(docx.data(), docx.size())) {
+        std::cerr << "Failed to open the generated document" << std::endl;
+        return 1;
+    }
+    std::string documentXml, stylesXml, footnotesXml;
+    zip.extract("word/document.xml", documentXml);
+    zip.extract("word/styles.xml", stylesXml);
+    zip.extract("word/footnotes.xml", footnotesXml);
+    std::string stylesCopy = stylesXml;
+    auto styles = std::make_shared<const StyleTable>(buildStyleTable(parseStyles(stylesCopy)));
+
+    const bool peakPerBenchmark = resetPeakRss();
+    std::cout << "Corpus: " << shape.paragraphs << " paragraphs x " << shape.runsPerParagraph << " runs, style depth "
+              << shape.styleDepth << ", " << shape.footnotes << " footnotes, " << shape.media << " media of "
+              << shape.mediaSize << " bytes" << std::endl
+              << "        " << docx.size() << " bytes zipped, document.xml " << documentXmlSize << " bytes" << std::endl
+              << "MB/s is relative to the uncompressed input part of each benchmark; the peak RSS is the" << std::endl
+              << (peakPerBenchmark ? "high-water mark during the benchmark, the corpus held in memory included."
+                                   : "process high-water mark after the benchmark (it cannot be reset here).")
+              << std::endl << std::endl;
+
+    // The parsers work in place, so the stages parse a fresh copy of their input;
+    // the copy is part of the measured time.
+    std::vector<Benchmark> benchmarks = {
+        { "stage/inflate_document_xml", documentXml.size(), [&] {
+            std::string out;
+            zip.extract("word/document.xml", out);
+            return size_t(0);
+        } },
+        { "stage/parse_styles", stylesXml.size(), [&] {
+            std::string xml = stylesXml;
+            StyleTable table = buildStyleTable(parseStyles(xml));
+            return size_t(0);
+        } },
+        { "stage/parse_footnotes", footnotesXml.size(), [&] {
+            std::string xml = footnotesXml;
+            StyleContext ctx(styles);
+            return parseFootnotes(xml, ctx, std::allocator<char>()).size();
+        } },
+        { "stage/parse_body", documentXml.size(), [&] {
+            std::string xml = documentXml;
+            StyleContext ctx(styles);
+            size_t paragraphs = 0;
+            streamBodyBlocks(xml, [&](BlockEvent event, XMLElement* p) {
+                if (event == BlockEvent::Paragraph) {
+                    readParagraph(p, ctx, std::allocator<char>());
+                    ++paragraphs;
+                }
+                return true;
+            });
+            return paragraphs;
+        } },
+        { "stage/inflate_and_parse_body", documentXml.size(), [&] {
+            StyleContext ctx(styles);
+            std::vector<Table> tables;
+            return parseMainDocument(zip, ctx, std::allocator<char>(), tables).size();
+        } },
+        { "readDocument", documentXml.size(), [&] {
+            return readDocument(path.string()).paragraphs.size();
+        } },
+        { "readDocument/memoryMap", documentXml.size(), [&] {
+            ReadOptions options;
+            options.memoryMap = true;
+            return readDocument(path.string(), options).paragraphs.size();
+        } },
+        { "readDocument/intraDocumentParallelism", documentXml.size(), [&] {
+            ReadOptions options;
+            options.intraDocumentParallelism = true;
+            return readDocument(path.string(), options).paragraphs.size();
+        } },
+        { "readDocument/textOnly", documentXml.size(), [&] {
+            ReadOptions options;
+            options.readStyles = false;
+            options.readFootnotes = false;
+            options.readEndnotes = false;
+            options.resolveFormatting = false;
+            return readDocument(path.string(), options).paragraphs.size();
+        } },
+        { "openDocument", documentXml.size(), [&] {
+            return openDocument(path.string()).paragraphs().size();
+        } },
+        { "openDocument/footnotes", documentXml.size(), [&] {
+            LazyDocument doc = openDocument(path.string());
+            return doc.paragraphs().size() + doc.footnotes().size();
+        } },
+        { "extractText", documentXml.size(), [&] {
+            std::string text = extractText(path.string());
+            return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+        } },
+        { "readDocumentView", documentXml.size(), [&] {
+            return readDocumentView(path.string()).paragraphs.size();
+        } },
+        { "forEachParagraph", documentXml.size(), [&] {
+            size_t paragraphs = 0;
+            forEachParagraph(path.string(), [&](Paragraph&&, const std::vector<RunFormat>&) {
+                ++paragraphs;
+                return true;
+            });
+            return paragraphs;
+        } },
+        { "readDocuments/batch8", 8 * documentXml.size(), [&] {
+            std::atomic<size_t> paragraphs(0);
+            readDocuments(std::vector<std::string>(8, path.string()), 0, [&](size_t, Document&& doc) {
+                paragraphs += doc.paragraphs.size();
+            });
+            return paragraphs.load();
+        } },
+        { "readDocumentFromMemory", documentXml.size(), [&] {
+            return readDocumentFromMemory(docx.data(), docx.size()).paragraphs.size();
+        } },
+        { "readArenaDocumentFromMemory", documentXml.size(), [&] {
+            return readArenaDocumentFromMemory(docx.data(), docx.size()).paragraphs.size();
+        } },
+    };
+
+    std::cout << std::left << std::setw(36) << "Benchmark" << std::right << std::setw(15) << "Time"
+              << std::setw(8) << "Iter" << std::setw(16) << "Throughput" << std::setw(20) << "Paragraphs"
+              << std::setw(12) << "Peak RSS" << std::endl
+              << std::string(107, '-') << std::endl;
+    for (const Benchmark& bench : benchmarks) {
+        if (filter.empty() || bench.name.find(filter) != std::string::npos)
+            runBenchmark(bench, minTime);
+    }
+
+    fs::remove(path);
+    return 0;
+}
@@ -0,0 +1,297 @@
+// Tests of the streaming scanners of miniDockReader
+// The body of a document is read by BodyScanner, and the text of extractText
+// by TextScanner, from chunks of inflated data cut anywhere. Each fixture
+// below is fed to them in chunks of every size from 1 byte to the whole
+// part, and what they report must match walkBlocks over a DOM of the
+// complete part: the same block events, and the text of the same
+// paragraphs in the same order.
+//
+// The library source is compiled into this file, so the scanners (which are
+// internal) can be driven directly:
+//   g++ -std=c++17 -O2 -pthread test/scanner_test.cpp thirdparty/tinyxml2-master/tinyxml2.cpp -o scanner_test
+//
+// Usage: scanner_test; the exit status is the number of failed checks
+
+#include "../src/miniDockReader.cpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ---------------- Fixtures ----------------
+
+// Wraps body content into a main document part
+std::string mainDocument(const std::string& body) {
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+           "<?mso-application progid=\"Word.Document\" note=\"</w:body>\"?>"
+           "<!DOCTYPE w:document [ <!ENTITY e \"<w:body>\"> ]>"
+           "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\""
+           " xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">"
+           "<!-- <w:body><w:p><w:r><w:t>not the body</w:t></w:r></w:p></w:body> -->"
+           "<w:background w:color=\"FFFFFF\"/>" + body + "</w:document>";
+}
+
+// @return a paragraph with one run of text
+std::string paragraph(const std::string& text) {
+    return "<w:p><w:r><w:t>" + text + "</w:t></w:r></w:p>";
+}
+
+// @return a run holding a text box with the given content, and the
+//         mc:Fallback copy of it that readers skip
+std::string textBox(const std::string& content) {
+    return "<w:r><mc:AlternateContent><mc:Choice Requires=\"wps\"><w:drawing><wp:anchor>"
+           "<a:graphic><wps:txbx><w:txbxContent>" + content + "</w:txbxContent></wps:txbx></a:graphic>"
+           "</wp:anchor></w:drawing></mc:Choice><mc:Fallback><w:pict><v:textbox><w:txbxContent>"
+           + paragraph("fallback") + "</w:txbxContent></v:textbox></w:pict></mc:Fallback>"
+           "</mc:AlternateContent></w:r>";
+}
+
+struct Fixture {
+    const char* name;
+    std::string xml;
+};
+
+std::vector<Fixture> fixtures() {
+    return {
+        { "empty body", mainDocument("<w:body/>") },
+        { "no paragraphs", mainDocument("<w:body><w:sectPr><w:pgSz w:w=\"11906\"/></w:sectPr></w:body>") },
+        { "markup", mainDocument(
+            "<w:body>"
+            "<!-- <w:p><w:r><w:t>comment</w:t></w:r></w:p> </w:body> -->"
+            + paragraph("&lt;a&gt; &amp; &quot;q&quot; &apos;s&apos; &#233;&#x4E2D;&#128512;") +
+            "<w:p w:rsidR=\"00A1\"\n\tw:rsidRDefault=\"00A1\" ><w:pPr><w:pStyle w:val=\"a>b\"/></w:pPr>"
+            "<w:r><w:rPr><w:rStyle w:val='c/>d'/></w:rPr><w:t xml:space=\"preserve\">  spaced  </w:t></w:r></w:p>"
+            "<w:p><w:r><w:t><![CDATA[< </w:p></w:body> & ]]></w:t></w:r></w:p>"
+            "<w:bookmarkStart w:id=\"0\" w:name=\"x>y\"/>"
+            "<w:p/><w:p />"
+            "<w:p><w:r><w:footnoteReference w:id=\"2\"/></w:r><w:r><w:t>noted</w:t></w:r></w:p>"
+            "<w:bookmarkEnd w:id=\"0\"/>"
+            "<w:sectPr><w:pgSz w:w=\"11906\"/></w:sectPr>"
+            "</w:body>") },
+        { "content controls", mainDocument(
+            "<w:body>"
+            "<w:sdt><w:sdtPr><w:alias w:val=\"outer\"/><w:placeholder><w:docPart w:val=\"x\"/></w:placeholder></w:sdtPr>"
+            "<w:sdtContent>" + paragraph("outer") +
+            "<w:customXml w:element=\"item\"><w:sdt><w:sdtContent>" + paragraph("inner") +
+            "</w:sdtContent></w:sdt></w:customXml>"
+            "<w:sdt><w:sdtContent/></w:sdt>"
+            "</w:sdtContent></w:sdt>"
+            + paragraph("after") +
+            "</w:body>") },
+        { "tables", mainDocument(
+            "<w:body>"
+            "<w:tbl><w:tblPr><w:tblStyle w:val=\"grid>1\"/><w:tblCaption w:val='a \"b\" c>'/></w:tblPr><w:tblGrid><w:gridCol/><w:gridCol/></w:tblGrid>"
+            "<w:tr><w:trPr/><w:tc><w:tcPr><w:gridSpan w:val=\"2\"/></w:tcPr>" + paragraph("a") +
+            "<w:tbl><w:tr><w:tc><w:tcPr><w:vMerge w:val=\"restart\"/></w:tcPr>" + paragraph("nested") +
+            "</w:tc><w:tc/></w:tr><w:tr><w:tc><w:tcPr><w:vMerge/></w:tcPr><w:p/></w:tc></w:tr></w:tbl>"
+            + paragraph("b") + "</w:tc>"
+            "<w:sdt><w:sdtContent><w:tc>" + paragraph("in control") + "</w:tc></w:sdtContent></w:sdt>"
+            "</w:tr><w:tr/>"
+            "<w:customXml w:element=\"row\"><w:tr><w:tc>" + paragraph("custom row") + "</w:tc></w:tr></w:customXml>"
+            "</w:tbl>"
+            "<w:tbl/>"
+            + paragraph("after") +
+            "</w:body>") },
+        { "runs", mainDocument(
+            "<w:body>"
+            "<w:p><w:pPr><w:tabs><w:tab w:val=\"left\" w:pos=\"720\"/></w:tabs></w:pPr>"
+            "<w:r><w:t>  first  </w:t><w:tab/><w:t xml:space='preserve'> second </w:t><w:br/><w:t>third</w:t><w:cr/></w:r>"
+            "<w:hyperlink r:id=\"rId1\"><w:r><w:t>link</w:t></w:r></w:hyperlink>"
+            "<w:ins w:id=\"1\"><w:r><w:t>&#x10FFFF;&#0x41;&#65;</w:t></w:r></w:ins>"
+            "<w:r><w:t>   </w:t><w:t/></w:r></w:p>"
+            "</w:body>") },
+        { "text boxes", mainDocument(
+            "<w:body>"
+            "<w:p><w:r><w:t>anchor</w:t></w:r>"
+            + textBox(paragraph("box") + "<w:p><w:r><w:t>outer box</w:t></w:r>" + textBox(paragraph("inner box")) + "</w:p>") +
+            "<w:r><w:t>anchor end</w:t></w:r></w:p>"
+            "<w:tbl><w:tr><w:tc><w:p>" + textBox("<w:tbl><w:tr><w:tc>" + paragraph("box cell") + "</w:tc></w:tr></w:tbl>") +
+            "</w:p></w:tc></w:tr></w:tbl>"
+            "</w:body>") },
+    };
+}
+
+// Wraps notes into a footnotes part, after its two separator notes
+std::string footnotes(const std::string& notes) {
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+           "<w:footnotes xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">"
+           "<w:footnote w:type=\"separator\" w:id=\"-1\">" + paragraph("separator") + "</w:footnote>"
+           "<w:footnote w:type=\"continuationSeparator\" w:id=\"0\">" + paragraph("continued") + "</w:footnote>"
+           + notes + "</w:footnotes>";
+}
+
+std::vector<Fixture> notesFixtures() {
+    return {
+        { "footnotes", footnotes(
+            "<w:footnote w:id=\"1\">" + paragraph("one") + "<!-- " + paragraph("comment") + " -->"
+            "<w:p><w:r><w:footnoteRef/></w:r><w:r><w:t xml:space=\"preserve\"> &amp; two</w:t></w:r></w:p></w:footnote>"
+            "<w:footnote w:id=\"2\"><w:p>" + textBox(paragraph("box")) + "<w:r><w:t>anchor</w:t></w:r></w:p>"
+            "<w:tbl><w:tr><w:tc>" + paragraph("cell") + "</w:tc></w:tr></w:tbl><w:p/></w:footnote>") },
+    };
+}
+
+// ---------------- Checks ----------------
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        ++failures;
+        std::cout << "FAILED: " << what << std::endl;
+    }
+}
+
+// @return the event name, followed by the printed element of a paragraph
+//         or of cell properties
+std::string describe(BlockEvent event, XMLElement* e) {
+    static const char* names[] = { "P", "TS", "TE", "RS", "RE", "CS", "CE", "CP" };
+    std::string text = names[static_cast<int>(event)];
+    if (event == BlockEvent::Paragraph || event == BlockEvent::CellProperties) {
+        XMLPrinter printer(nullptr, true);
+        e->Accept(&printer);
+        text += ' ';
+        text += printer.CStr();
+    }
+    return text;
+}
+
+// @return the block events of walkBlocks over a DOM of the whole document
+std::vector<std::string> domEvents(const std::string& xml) {
+    std::vector<std::string> events;
+    XMLDocument doc;
+    if (doc.Parse(xml.c_str(), xml.size()) != XML_SUCCESS)
+        return { "parse error" };
+    XMLElement* body = doc.RootElement()->FirstChildElement("w:body");
+    walkBlocks(body->FirstChildElement(), [&](BlockEvent event, XMLElement* e) {
+        events.push_back(describe(event, e));
+        return true;
+    });
+    return events;
+}
+
+// @param step: chunk size
+// @param limit: number of events after which the callback stops
+// @return the block events of the body scanner fed in chunks of step bytes
+std::vector<std::string> chunkedEvents(const std::string& xml, size_t step, size_t limit = SIZE_MAX) {
+    std::vector<std::string> events;
+    BodyStream stream([&](BlockEvent event, XMLElement* e) {
+        events.push_back(describe(event, e));
+        return events.size() < limit;
+    });
+    for (size_t pos = 0; pos < xml.size(); pos += step) {
+        if (!stream.feed(xml.data() + pos, std::min(step, xml.size() - pos)))
+            break;
+    }
+    return events;
+}
+
+void testBodyScanner(const Fixture& fixture) {
+    const std::vector<std::string> expected = domEvents(fixture.xml);
+    check(expected.empty() || expected[0] != "parse error", std::string(fixture.name) + ": fixture is well-formed");
+
+    std::string xml = fixture.xml;
+    std::vector<std::string> whole;
+    streamBodyBlocks(xml, [&](BlockEvent event, XMLElement* e) {
+        whole.push_back(describe(event, e));
+        return true;
+    });
+    check(whole == expected, std::string(fixture.name) + ": in-memory body events");
+
+    for (size_t step = 1; step <= fixture.xml.size(); ++step) {
+        if (chunkedEvents(fixture.xml, step) != expected) {
+            check(false, std::string(fixture.name) + ": body events in chunks of " + std::to_string(step) + " bytes");
+            break;
+        }
+    }
+
+    // Stopping after any event ends the scan there
+    for (size_t limit = 1; limit < expected.size(); ++limit) {
+        std::vector<std::string> prefix(expected.begin(), expected.begin() + limit);
+        if (chunkedEvents(fixture.xml, 7, limit) != prefix) {
+            check(false, std::string(fixture.name) + ": body events stopped after " + std::to_string(limit));
+            break;
+        }
+    }
+}
+
+// @return the text of a paragraph, as the text scanner extracts it
+std::string paragraphText(XMLElement* p) {
+    std::string text;
+    walkRuns(p, [&](XMLElement* r) {
+        for (XMLElement* e = r->FirstChildElement(); e; e = e->NextSiblingElement()) {
+            std::string name = e->Name();
+            if (name == "w:tab") {
+                text += '\t';
+            } else if (name == "w:br" || name == "w:cr") {
+                text += ' ';
+            } else if (name == "w:t" && e->GetText()) {
+                std::string t = e->GetText();
+                const char* space = e->Attribute("xml:space");
+                if (!space || std::string(space) != "preserve") {
+                    t.erase(0, t.find_first_not_of(' ') == std::string::npos ? t.size() : t.find_first_not_of(' '));
+                    t.erase(t.find_last_not_of(' ') + 1);
+                }
+                text += t;
+            }
+        }
+    });
+    return text;
+}
+
+// @param body: the part is a main document, of which only the body is read
+// @return the text of the paragraphs walkBlocks reports over a DOM of the
+//         whole part, one line each; separator notes are skipped
+std::string domText(const std::string& xml, bool body) {
+    XMLDocument doc;
+    if (doc.Parse(xml.c_str(), xml.size()) != XML_SUCCESS)
+        return "parse error";
+    std::string text;
+    auto onBlock = [&](BlockEvent event, XMLElement* e) {
+        if (event == BlockEvent::Paragraph)
+            text += paragraphText(e) + '\n';
+        return true;
+    };
+    if (body) {
+        walkBlocks(doc.RootElement()->FirstChildElement("w:body")->FirstChildElement(), onBlock);
+        return text;
+    }
+    for (XMLElement* note = doc.RootElement()->FirstChildElement(); note; note = note->NextSiblingElement()) {
+        const char* type = note->Attribute("w:type");
+        if (!type || (std::string(type) != "separator" && std::string(type) != "continuationSeparator"))
+            walkBlocks(note->FirstChildElement(), onBlock);
+    }
+    return text;
+}
+
+// @return the text of the text scanner fed in chunks of step bytes
+std::string chunkedText(const std::string& xml, bool body, size_t step) {
+    TextScanner scanner(body);
+    std::string text;
+    for (size_t pos = 0; pos < xml.size() && !scanner.done(); pos += step)
+        scanner.feed(xml.data() + pos, std::min(step, xml.size() - pos), text);
+    return text;
+}
+
+void testTextScanner(const Fixture& fixture, bool body) {
+    const std::string expected = domText(fixture.xml, body);
+    check(expected != "parse error", std::string(fixture.name) + ": fixture is well-formed");
+    for (size_t step = 1; step <= fixture.xml.size(); ++step) {
+        std::string text = chunkedText(fixture.xml, body, step);
+        if (text != expected) {
+            check(false, std::string(fixture.name) + ": text in chunks of " + std::to_string(step) + " bytes is\n" +
+                         text + "instead of\n" + expected);
+            break;
+        }
+    }
+}
+
+int main() {
+    for (const Fixture& fixture : fixtures()) {
+        testBodyScanner(fixture);
+        testTextScanner(fixture, true);
+    }
+    for (const Fixture& fixture : notesFixtures())
+        testTextScanner(fixture, false);
+    std::cout << (failures ? "Some checks failed" : "All checks passed") << std::endl;
+    return failures;
+}
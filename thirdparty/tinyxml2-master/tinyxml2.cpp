@@ -2210,6 +2210,7 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorStr(),
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
+    _charBufferOwned( true ),
     _parseCurLineNum( 0 ),
 	_parsingDepth(0),
     _unlinked(),
@@ -2254,8 +2255,11 @@ void XMLDocument::Clear()
 #endif
     ClearError();
 
-    delete [] _charBuffer;
+    if ( _charBufferOwned ) {
+        delete [] _charBuffer;
+    }
     _charBuffer = 0;
+    _charBufferOwned = true;
 	_parsingDepth = 0;
 
 #if 0
@@ -2496,6 +2500,31 @@ XMLError XMLDocument::Parse( const char* xml, size_t nBytes )
 }
 
 
+XMLError XMLDocument::ParseInPlace( char* xml, size_t nBytes )
+{
+    Clear();
+
+    if ( nBytes == 0 || !xml || !*xml ) {
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+    TIXMLASSERT( _charBuffer == 0 );
+    TIXMLASSERT( xml[nBytes] == 0 );
+    _charBuffer = xml;
+    _charBufferOwned = false;
+
+    Parse();
+    if ( Error() ) {
+        DeleteChildren();
+        _elementPool.Clear();
+        _attributePool.Clear();
+        _textPool.Clear();
+        _commentPool.Clear();
+    }
+    return _errorID;
+}
+
+
 void XMLDocument::Print( XMLPrinter* streamer ) const
 {
     if ( streamer ) {
@@ -1751,6 +1751,17 @@ public:
     */
     XMLError Parse( const char* xml, size_t nBytes=static_cast<size_t>(-1) );
 
+    /**
+    	Parse an XML string in place, without copying it.
+    	(miniDockReader addition)
+
+    	'xml' must be writable, null terminated at xml[nBytes]
+    	and must outlive the document: the parser decodes names,
+    	attributes and text directly in this buffer and the nodes
+    	point into it. The document does not take ownership.
+    */
+    XMLError ParseInPlace( char* xml, size_t nBytes );
+
     /**
     	Load an XML file from disk.
     	Returns XML_SUCCESS (0) on success, or
@@ -1940,6 +1951,7 @@ private:
     mutable StrPair	_errorStr;
     int             _errorLineNum;
     char*			_charBuffer;
+    bool			_charBufferOwned;
     int				_parseCurLineNum;
 	int				_parsingDepth;
 	// Memory tracking does add some overhead.